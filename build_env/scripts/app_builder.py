@@ -29,10 +29,10 @@ def main():
     if exit_status != 0:
         sys.exit("\nError compiling applications' source code\n");
     
-    #Generate the repository.txt and repository_debug.txt files, returning a list of tuple {app_name, repo_address}
+    #Generate the repository.txt, repository.img and repository_debug.txt files, returning a list of tuple {app_name, repo_address}
     apps_repo_addr_list = generate_repository(yaml_r, apps_name_list, processor_arch);
     
-    #Generates the appstart.txt and appstart_debug.txt files
+    #Generates the appstart.txt, appstart.img and appstart_debug.txt files
     generate_appstart(apps_repo_addr_list, yaml_r)
     
 
@@ -222,6 +222,7 @@ def generate_repository_file(repo_lines, system_model_description):
         file_debug_lines.append(debug_line)
         
     writes_file_into_testcase(repo_file_path, file_lines)
+    writes_image_into_testcase("repository.img", file_lines)
     writes_file_into_testcase(repo_debug_file_path, file_debug_lines)
 
 def generate_appstart_file(apps_start_obj_list):
@@ -248,6 +249,7 @@ def generate_appstart_file(apps_start_obj_list):
     file_debug_lines.append(hex(address)+"\t\t0xdeadc0de\tend of file indicator\n")
         
     writes_file_into_testcase(appstart_file_path, file_lines)
+    writes_image_into_testcase("appstart.img", file_lines)
     writes_file_into_testcase(appstart_debug_file_path, file_debug_lines)
         
 def get_task_txt_size(app_name, task_name):
@@ -3,6 +3,8 @@ import sys
 import os
 import filecmp
 import commands
+import struct
+import zlib
 from shutil import copyfile, rmtree
 from math import ceil
 
@@ -39,6 +41,10 @@ def create_cluster_list(x_mpsoc_dim, y_mpsoc_dim, x_cluster_dim, y_cluster_dim,
    
     if  ( x_mpsoc_dim % x_cluster_dim ) != 0 or (y_mpsoc_dim % y_cluster_dim ) != 0:
         sys.exit('Error in YAML noc_dimension OR cluster_dimension - you must provide a compatible dimension')
+    
+    #The router address is {x, y} with 8 bits each, both in the NoC headers and in the kernel
+    if x_mpsoc_dim > 256 or y_mpsoc_dim > 256:
+        sys.exit('Error in YAML mpsoc_dimension - the router address supports up to 256x256 PEs')
         
     x_clusters_number = x_mpsoc_dim / x_cluster_dim;
     y_clusters_number = y_mpsoc_dim / y_cluster_dim;
@@ -97,6 +103,18 @@ def writes_file_into_testcase(file_path, file_lines):
     copyfile(tmp_file_path, file_path)
     os.remove(tmp_file_path)
 
+#Writes the binary memory image mapped by the simulator: a header {magic, version, number of words, CRC-32}
+#followed by the little-endian words. file_lines are the lines of the equivalent hex text file
+def writes_image_into_testcase(file_path, file_lines):
+    
+    words = [int(line[0:8], 16) for line in file_lines]
+    
+    data = struct.pack("<%dI" % len(words), *words)
+    
+    header = struct.pack("<4I", 0x4D494D48, 1, len(words), zlib.crc32(data) & 0xFFFFFFFF)
+    
+    writes_file_into_testcase(file_path, [header + data])
+
 #Check the page size, comparing the (code size + 50%) of the file_path
 #with the page_size. 
 def check_mem_size(file_path, mem_size_KB, tool_prefix):
@@ -83,6 +83,52 @@ def generate_to_systemc(is_master_list, yaml_r):
     x_mpsoc_dim =       get_mpsoc_x_dim(yaml_r)
     y_mpsoc_dim =       get_mpsoc_y_dim(yaml_r)
     app_number =        get_apps_number(yaml_r)
+    dmi_enable =        get_dmi_enable(yaml_r)
+    quantum_cycles =    get_quantum_cycles(yaml_r)
+    idle_pe_skip =      get_idle_pe_skip(yaml_r)
+    block_exec =        get_block_exec(yaml_r)
+    override_quantum = get_override_quantum(yaml_r)
+    tlb_entries =       get_tlb_entries(yaml_r)
+    tlb_ways =          get_tlb_ways(yaml_r)
+    noc_buffer_size =   get_noc_buffer_size(yaml_r)
+    
+    #The SystemC router buffers take any power of two depth in this range
+    if noc_buffer_size < 4 or noc_buffer_size > 64 or (noc_buffer_size & (noc_buffer_size - 1)) != 0:
+        sys.exit("ERROR: noc_buffer_size must be a power of two from 4 to 64")
+    
+    noc_vcs =           get_noc_vcs(yaml_r)
+    noc_vc_map =        get_noc_vc_map(yaml_r)
+    
+    #Virtual channels of the SystemC mesh links, VC_MAX in standards.h
+    if noc_vcs < 1 or noc_vcs > 4:
+        sys.exit("ERROR: noc_vcs must be from 1 to 4")
+    
+    string_vc_map_sc = ""
+    for service, vc in noc_vc_map:
+        if vc < 0 or vc >= noc_vcs:
+            sys.exit("ERROR: noc_vc_map sends service "+hex(service)+" to VC "+str(vc)+" of "+str(noc_vcs))
+        string_vc_map_sc = string_vc_map_sc + str(service) + ", " + str(vc) + ", "
+    string_vc_map_sc = string_vc_map_sc[0:len(string_vc_map_sc)-2]
+    
+    #The packets of different VCs overtake each other, the services unmapped use VC 0
+    service_vc = dict((service, vc) for service, vc in noc_vc_map)
+    for group in ORDERED_SERVICE_GROUPS:
+        group_vcs = set(service_vc.get(service, 0) for service in group)
+        if len(group_vcs) > 1:
+            sys.exit("ERROR: noc_vc_map must send the services "+", ".join(hex(service) for service in group)+" to the same VC, the kernel expects them in order")
+    
+    #Routing algorithms of the SystemC router, in the order of enum Routing in standards.h
+    routing_algorithms = ["xy", "west_first", "north_last", "negative_first", "odd_even"]
+    noc_routing =       get_noc_routing(yaml_r)
+    if noc_routing not in routing_algorithms:
+        sys.exit("ERROR: noc_routing must be one of: "+", ".join(routing_algorithms))
+    
+    #The buffers that wait for the service flit to pick the VC or the path need BUFFER_TAM_CLASSIFY in standards.h
+    if (noc_vcs > 1 or noc_routing != "xy") and noc_buffer_size < 8:
+        sys.exit("ERROR: noc_buffer_size must be at least 8 with virtual channels or adaptive routing")
+    
+    #The adaptive routing keeps these services on a single path
+    string_ordered_sc = ", ".join(str(service) for group in ORDERED_SERVICE_GROUPS for service in group)
     
     string_pe_type_sc = ""
     
@@ -102,18 +148,36 @@ def generate_to_systemc(is_master_list, yaml_r):
     
     file_lines.append("#define PAGE_SIZE_BYTES           "+str(page_size_KB*1024)+"\n")
     file_lines.append("#define MEMORY_SIZE_BYTES      "+str(memory_size_KB*1024)+"\n")
-    file_lines.append("#define TOTAL_REPO_SIZE_BYTES   "+str(repo_size_bytes)+"\n")
-    file_lines.append("#define APP_NUMBER           "+str(app_number)+"\n")
-    file_lines.append("#define N_PE_X              "+str(x_mpsoc_dim)+"\n")
-    file_lines.append("#define N_PE_Y              "+str(y_mpsoc_dim)+"\n")
-    file_lines.append("#define N_PE                "+str(x_mpsoc_dim*y_mpsoc_dim)+"\n\n")
+    file_lines.append("#define DMI_ENABLE          "+str(int(dmi_enable))+"\n")
+    file_lines.append("#define QUANTUM_CYCLES      "+str(quantum_cycles)+"\n")
+    file_lines.append("#define IDLE_PE_SKIP        "+str(int(idle_pe_skip))+"\n")
+    file_lines.append("#define BLOCK_EXEC          "+str(int(block_exec))+"\n")
+    file_lines.append("#define OVERRIDE_QUANTUM "+str(override_quantum)+"\n")
+    file_lines.append("#define TLB_ENTRIES         "+str(tlb_entries)+"\n")
+    file_lines.append("#define TLB_WAYS            "+str(tlb_ways)+"\n\n")
     
-    file_lines.append("const int pe_type[N_PE] = {"+string_pe_type_sc+"};\n\n")
     file_lines.append("#endif\n")
     
     #Use this function to create any file into testcase, it automatically only updates the old file if necessary
     writes_file_into_testcase("include/hemps_pkg.h", file_lines)
     
+    #The mesh is elaborated at runtime from this file, so changing its size or the applications does not rebuild the simulator
+    file_lines = []
+    file_lines.append("{\n")
+    file_lines.append("    \"n_pe_x\": "+str(x_mpsoc_dim)+",\n")
+    file_lines.append("    \"n_pe_y\": "+str(y_mpsoc_dim)+",\n")
+    file_lines.append("    \"repository_size_bytes\": "+str(repo_size_bytes)+",\n")
+    file_lines.append("    \"app_number\": "+str(app_number)+",\n")
+    file_lines.append("    \"noc_buffer_size\": "+str(noc_buffer_size)+",\n")
+    file_lines.append("    \"noc_vcs\": "+str(noc_vcs)+",\n")
+    file_lines.append("    \"noc_vc_map\": ["+string_vc_map_sc+"],\n")
+    file_lines.append("    \"noc_routing\": "+str(routing_algorithms.index(noc_routing))+",\n")
+    file_lines.append("    \"noc_ordered_services\": ["+string_ordered_sc+"],\n")
+    file_lines.append("    \"pe_type\": ["+string_pe_type_sc+"]\n")
+    file_lines.append("}\n")
+    
+    writes_file_into_testcase("include/platform.json", file_lines)
+    
 
 def generate_to_vhdl(is_master_list, yaml_r):
     
@@ -202,6 +202,11 @@ def generate_memory( yaml_r ):
             sys.exit("ERROR: Error in the ram_generation process")
         
     else:
+        #Binary images of the kernels, mapped by the simulator instead of parsing the text files
+        for kernel in ["kernel_master", "kernel_slave"]:
+            with open("software/"+kernel+".txt") as kernel_file:
+                writes_image_into_testcase("software/"+kernel+".img", kernel_file.readlines())
+        
         cluster_list = create_cluster_list(x_mpsoc_dim, y_mpsoc_dim, x_cluster_dim, y_cluster_dim, master_location)
         
         for x in range(0, x_mpsoc_dim):
@@ -215,10 +220,14 @@ def generate_memory( yaml_r ):
                 
                 dst_ram_file = memory_path+"/ram"+str(x)+"x"+str(y)+".txt"
                 
+                dst_img_file = memory_path+"/ram"+str(x)+"x"+str(y)+".img"
+                
                 if master_pe == True:
                     os.symlink("../software/kernel_master.txt", dst_ram_file)
+                    os.symlink("../software/kernel_master.img", dst_img_file)
                 else:
                     os.symlink("../software/kernel_slave.txt", dst_ram_file)
+                    os.symlink("../software/kernel_slave.img", dst_img_file)
               
       
 main()
\ No newline at end of file
@@ -49,6 +49,40 @@ def get_model_description(yaml_reader):
 def get_noc_buffer_size(yaml_reader):
     return yaml_reader["hw"]["noc_buffer_size"]
 
+def get_noc_routing(yaml_reader):
+    try:
+        return yaml_reader["hw"]["noc_routing"]
+    except:
+        return "xy"
+
+def get_noc_vcs(yaml_reader):
+    try:
+        return yaml_reader["hw"]["noc_vcs"]
+    except:
+        return 1
+
+#Services the kernel expects to receive in the order they were sent by the same PE. The NoC keeps
+#the order of the packets of a VC, not across VCs, so each group must use a single VC. The adaptive
+#routing sends these services on a single path
+ORDERED_SERVICE_GROUPS = [
+    [0x40, 0x250],                                      #TASK_ALLOCATION, TASK_RELEASE
+    [0x210, 0x220, 0x221, 0x222, 0x223, 0x224, 0x225],  #TASK_MIGRATION and the MIGRATION_* packets
+]
+
+#Pairs of service and VC. By default the bulk data packets (MESSAGE_DELIVERY and the groups of
+#TASK_ALLOCATION and of the task migration) use VC 1 and the control packets VC 0
+def get_noc_vc_map(yaml_reader):
+    try:
+        return yaml_reader["hw"]["noc_vc_map"]
+    except:
+        if get_noc_vcs(yaml_reader) > 1:
+            vc_map = [[0x20, 1]]
+            for group in ORDERED_SERVICE_GROUPS:
+                for service in group:
+                    vc_map.append([service, 1])
+            return vc_map
+        return []
+
 def get_mpsoc_x_dim(yaml_reader):
     return yaml_reader["hw"]["mpsoc_dimension"][0]
 
@@ -70,6 +104,48 @@ def get_processor_arch(yaml_reader):
     except:
         return "plasma"
 
+def get_dmi_enable(yaml_reader):
+    try:
+        return yaml_reader["hw"]["dmi"]
+    except:
+        return False
+
+def get_quantum_cycles(yaml_reader):
+    try:
+        return yaml_reader["hw"]["quantum_cycles"]
+    except:
+        return 0
+
+def get_block_exec(yaml_reader):
+    try:
+        return yaml_reader["hw"]["block_exec"]
+    except:
+        return False
+
+def get_override_quantum(yaml_reader):
+    try:
+        return yaml_reader["hw"]["override_quantum"]
+    except:
+        return 10000
+
+def get_tlb_entries(yaml_reader):
+    try:
+        return yaml_reader["hw"]["tlb"][0]
+    except:
+        return 64
+
+def get_tlb_ways(yaml_reader):
+    try:
+        return yaml_reader["hw"]["tlb"][1]
+    except:
+        return 4
+
+def get_idle_pe_skip(yaml_reader):
+    try:
+        return yaml_reader["hw"]["idle_pe_skip"]
+    except:
+        return False
+
 def get_mapping_algorithm(yaml_reader):
     return yaml_reader["sw"]["mapping_algorithm"]
 
@@ -0,0 +1,128 @@
+/*
+ * checkpoint.h
+ *
+ *  Serialization of the platform state to a binary checkpoint file.
+ *
+ *  Each module visits its state with checkpoint(Checkpoint &ckp). The same
+ *  visit saves or loads, depending on how the Checkpoint was opened, so the
+ *  file layout always matches the visiting order.
+ *
+ *  CPUs are only consistent at instruction boundaries. While park() is
+ *  requested they stall at the top of their loop, and a held CPU keeps its
+ *  clock until it gets there, so the platform is saved or loaded with every
+ *  CPU between two instructions.
+ */
+
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <systemc.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <type_traits>
+
+#define CHECKPOINT_MAGIC	0x484D4350	// "HMCP"
+#define CHECKPOINT_VERSION	8
+
+#ifdef RISCV_SIM
+	#define CHECKPOINT_CPU	1
+#else
+	#define CHECKPOINT_CPU	0
+#endif
+
+class Checkpoint {
+public:
+	Checkpoint(const char *filename, bool save_) : save(save_), error(false) {
+		fp = fopen(filename, save ? "wb" : "rb");
+		if (fp == NULL)
+			error = true;
+	}
+
+	~Checkpoint() {
+		if (fp != NULL)
+			fclose(fp);
+	}
+
+	bool saving() { return save; }
+	bool ok() { return !error; }
+
+	// Checks or writes a header value. Fails the checkpoint on mismatch
+	void expect(uint32_t value) {
+		uint32_t read = value;
+		io(read);
+		if (read != value)
+			error = true;
+	}
+
+	/*** Plain values ***/
+	template <typename T>
+	typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type io(T &value) {
+		if (error)
+			return;
+		if ((save ? fwrite(&value, sizeof(T), 1, fp) : fread(&value, sizeof(T), 1, fp)) != 1)
+			error = true;
+	}
+
+	template <int W>
+	void io(sc_uint<W> &value) {
+		uint64_t v = value;
+		io(v);
+		value = v;
+	}
+
+	template <typename T, size_t N>
+	void io(T (&array)[N]) {
+		for (size_t i = 0; i < N; i++)
+			io(array[i]);
+	}
+
+	template <typename T>
+	void io(T *array, size_t n) {
+		for (size_t i = 0; i < n; i++)
+			io(array[i]);
+	}
+
+	// Registers accessed through read() and write()
+	template <typename R>
+	void io_reg(R &reg) {
+		uint32_t v = (uint32_t)reg.read();
+		io(v);
+		if (!save)
+			reg.write(v);
+	}
+
+	/*** Signals. Loaded values are applied on the next update phase ***/
+	void io(sc_signal<bool> &signal) {
+		bool v = signal.read();
+		io(v);
+		if (!save)
+			signal.write(v);
+	}
+
+	template <int W>
+	void io(sc_signal<sc_uint<W> > &signal) {
+		uint64_t v = signal.read();
+		io(v);
+		if (!save)
+			signal.write(v);
+	}
+
+	template <typename E>
+	typename std::enable_if<std::is_enum<E>::value>::type io(sc_signal<E> &signal) {
+		uint32_t v = signal.read();
+		io(v);
+		if (!save)
+			signal.write((E)v);
+	}
+
+	/*** CPU parking ***/
+	static bool &park() { static bool request = false; return request; }
+	static int &parked() { static int cpus = 0; return cpus; }
+
+private:
+	FILE *fp;
+	bool save;
+	bool error;
+};
+
+#endif /* CHECKPOINT_H_ */
@@ -17,10 +17,10 @@
 int hemps::RouterPosition(int router){
 	int pos;
 	
-	int column = router%N_PE_X;
+	int column = router%n_pe_x;
 	
-	if(router>=(N_PE-N_PE_X)){ //TOP
-		if(column==(N_PE_X-1)){ //RIGHT
+	if(router>=(n_pe-n_pe_x)){ //TOP
+		if(column==(n_pe_x-1)){ //RIGHT
 			pos = TR;
 		}
 		else{
@@ -33,8 +33,8 @@ int hemps::RouterPosition(int router){
 		}
 	}
 	else{
-		if(router<N_PE_X){ //BOTTOM
-			if(column==(N_PE_X-1)){ //RIGHT
+		if(router<n_pe_x){ //BOTTOM
+			if(column==(n_pe_x-1)){ //RIGHT
 				pos = BR;
 			}
 			else{
@@ -47,7 +47,7 @@ int hemps::RouterPosition(int router){
 			}
 		}
 		else{//CENTER_Y
-			if(column==(N_PE_X-1)){ //RIGHT
+			if(column==(n_pe_x-1)){ //RIGHT
 				pos = CRX;
 			}
 			else{
@@ -67,8 +67,8 @@ int hemps::RouterPosition(int router){
 regaddress hemps::RouterAddress(int router){
 	regaddress r_address;
 	
-	sc_uint<8> pos_y = (unsigned int) router/N_PE_X;
-	sc_uint<8> pos_x = router%N_PE_X;
+	sc_uint<8> pos_y = (unsigned int) router/n_pe_x;
+	sc_uint<8> pos_x = router%n_pe_x;
 
 	r_address[15] = pos_x[7];
 	r_address[14] = pos_x[6];
@@ -91,65 +91,86 @@ regaddress hemps::RouterAddress(int router){
 }
 
 
+//Binds each input port straight to the neighbour output, so a link only wakes the two PEs it connects
 void hemps::pes_interconnection(){
  	int i;
  	 	
- 	for(i=0;i<N_PE;i++){
+ 	for(i=0;i<n_pe;i++){
 		
 		//EAST GROUNDING
  		if(RouterPosition(i) == BR || RouterPosition(i) == CRX || RouterPosition(i) == TR){
- 			credit_i[i][EAST].write(0);
- 			clock_rx[i][EAST].write(0);
- 			data_in [i][EAST].write(0);
- 			rx      [i][EAST].write(0); 		
+ 			PE[i]->credit_i[EAST](ground_no_credit);
+ 			PE[i]->clock_rx[EAST](ground);
+ 			PE[i]->data_in [EAST](ground_data);
+ 			PE[i]->vc_in   [EAST](ground_vc);
+ 			PE[i]->rx      [EAST](ground);
 		}
  		else{//EAST CONNECTION
- 			credit_i[i][EAST].write(credit_o[i+1][WEST].read());
- 			clock_rx[i][EAST].write(clock_tx[i+1][WEST].read());
- 			data_in [i][EAST].write(data_out[i+1][WEST].read());
- 			rx      [i][EAST].write(tx      [i+1][WEST].read());
+ 			PE[i]->credit_i[EAST](credit_o[i+1][WEST]);
+ 			PE[i]->clock_rx[EAST](clock_tx[i+1][WEST]);
+ 			PE[i]->data_in [EAST](data_out[i+1][WEST]);
+ 			PE[i]->vc_in   [EAST](vc_out  [i+1][WEST]);
+ 			PE[i]->rx      [EAST](tx      [i+1][WEST]);
  		}
  		
  		//WEST GROUNDING
  		if(RouterPosition(i) == BL || RouterPosition(i) == CL || RouterPosition(i) == TL){
- 			credit_i[i][WEST].write(0);
- 			clock_rx[i][WEST].write(0);
- 			data_in [i][WEST].write(0);
- 			rx      [i][WEST].write(0);
+ 			PE[i]->credit_i[WEST](ground_no_credit);
+ 			PE[i]->clock_rx[WEST](ground);
+ 			PE[i]->data_in [WEST](ground_data);
+ 			PE[i]->vc_in   [WEST](ground_vc);
+ 			PE[i]->rx      [WEST](ground);
  		}
  		else{//WEST CONNECTION
-			credit_i[i][WEST].write(credit_o[i-1][EAST].read());
- 			clock_rx[i][WEST].write(clock_tx[i-1][EAST].read());
- 			data_in [i][WEST].write(data_out[i-1][EAST].read());
- 			rx      [i][WEST].write(tx      [i-1][EAST].read());
+			PE[i]->credit_i[WEST](credit_o[i-1][EAST]);
+ 			PE[i]->clock_rx[WEST](clock_tx[i-1][EAST]);
+ 			PE[i]->data_in [WEST](data_out[i-1][EAST]);
+ 			PE[i]->vc_in   [WEST](vc_out  [i-1][EAST]);
+ 			PE[i]->rx      [WEST](tx      [i-1][EAST]);
  		}
  		
  		//NORTH GROUNDING
  		if(RouterPosition(i) == TL || RouterPosition(i) == TC || RouterPosition(i) == TR){
- 			credit_i[i][NORTH].write(1);
- 			clock_rx[i][NORTH].write(0);
- 			data_in [i][NORTH].write(0);
- 			rx      [i][NORTH].write(0);
+ 			PE[i]->credit_i[NORTH](ground_credit);
+ 			PE[i]->clock_rx[NORTH](ground);
+ 			PE[i]->data_in [NORTH](ground_data);
+ 			PE[i]->vc_in   [NORTH](ground_vc);
+ 			PE[i]->rx      [NORTH](ground);
  		}
  		else{//NORTH CONNECTION
-			credit_i[i][NORTH].write(credit_o[i+N_PE_X][SOUTH].read());
- 			clock_rx[i][NORTH].write(clock_tx[i+N_PE_X][SOUTH].read());
- 			data_in [i][NORTH].write(data_out[i+N_PE_X][SOUTH].read());
- 			rx      [i][NORTH].write(tx      [i+N_PE_X][SOUTH].read());
+			PE[i]->credit_i[NORTH](credit_o[i+n_pe_x][SOUTH]);
+ 			PE[i]->clock_rx[NORTH](clock_tx[i+n_pe_x][SOUTH]);
+ 			PE[i]->data_in [NORTH](data_out[i+n_pe_x][SOUTH]);
+ 			PE[i]->vc_in   [NORTH](vc_out  [i+n_pe_x][SOUTH]);
+ 			PE[i]->rx      [NORTH](tx      [i+n_pe_x][SOUTH]);
  		}
  		
  		//SOUTH GROUNDING
  		if(RouterPosition(i) == BL || RouterPosition(i) == BC || RouterPosition(i) == BR){
- 			credit_i[i][SOUTH].write(0);
- 			clock_rx[i][SOUTH].write(0);
- 			data_in [i][SOUTH].write(0);
- 			rx      [i][SOUTH].write(0);
+ 			PE[i]->credit_i[SOUTH](ground_no_credit);
+ 			PE[i]->clock_rx[SOUTH](ground);
+ 			PE[i]->data_in [SOUTH](ground_data);
+ 			PE[i]->vc_in   [SOUTH](ground_vc);
+ 			PE[i]->rx      [SOUTH](ground);
  		}
  		else{//SOUTH CONNECTION
-			credit_i[i][SOUTH].write(credit_o[i-N_PE_X][NORTH].read());
- 			clock_rx[i][SOUTH].write(clock_tx[i-N_PE_X][NORTH].read());
- 			data_in [i][SOUTH].write(data_out[i-N_PE_X][NORTH].read());
- 			rx      [i][SOUTH].write(tx      [i-N_PE_X][NORTH].read());
+			PE[i]->credit_i[SOUTH](credit_o[i-n_pe_x][NORTH]);
+ 			PE[i]->clock_rx[SOUTH](clock_tx[i-n_pe_x][NORTH]);
+ 			PE[i]->data_in [SOUTH](data_out[i-n_pe_x][NORTH]);
+ 			PE[i]->vc_in   [SOUTH](vc_out  [i-n_pe_x][NORTH]);
+ 			PE[i]->rx      [SOUTH](tx      [i-n_pe_x][NORTH]);
  		}
  	}
 }
+
+void hemps::checkpoint(Checkpoint &ckp){
+
+	ckp.io(clock_tx, n_pe);
+	ckp.io(tx, n_pe);
+	ckp.io(data_out, n_pe);
+	ckp.io(vc_out, n_pe);
+	ckp.io(credit_o, n_pe);
+
+	for (j = 0; j < n_pe; j++)
+		PE[j]->checkpoint(ckp);
+}
@@ -33,26 +33,32 @@ SC_MODULE(hemps) {
 	sc_in< bool >			clock;
 	sc_in< bool >			reset;
 
+	// Mesh dimensions, given at elaboration
+	int n_pe_x, n_pe_y, n_pe;
+
 	//Tasks repository interface
-	sc_out<sc_uint<30> >	mem_addr[N_PE];
-	sc_in<sc_uint<32> >		data_read[N_PE];
+	sc_out<sc_uint<30> >	*mem_addr;
+	sc_in<sc_uint<32> >		*data_read;
 	
 	//Dynamic Insertion of Applications
-	sc_out<bool >			ack_app[N_PE];
-	sc_in<sc_uint<32> >		req_app[N_PE];
-	
-	// NoC Interface
-	sc_signal<bool >		clock_tx[N_PE][NPORT-1];
-	sc_signal<bool >		tx[N_PE][NPORT-1];
-	sc_signal<regflit >		data_out[N_PE][NPORT-1];
-	sc_signal<bool >		credit_i[N_PE][NPORT-1];
+	sc_out<bool >			*ack_app;
+	sc_in<sc_uint<32> >		*req_app;
 	
-	sc_signal<bool >		clock_rx[N_PE][NPORT-1];
-	sc_signal<bool > 		rx[N_PE][NPORT-1];
-	sc_signal<regflit >		data_in[N_PE][NPORT-1];
-	sc_signal<bool >		credit_o[N_PE][NPORT-1];
+	// NoC Interface - the input ports are bound to the neighbour outputs
+	sc_signal<bool >		(*clock_tx)[NPORT-1];
+	sc_signal<bool >		(*tx)[NPORT-1];
+	sc_signal<regflit >		(*data_out)[NPORT-1];
+	sc_signal<regvc >		(*vc_out)[NPORT-1];
+	sc_signal<regcredit >	(*credit_o)[NPORT-1];
+
+	// Grounding of the mesh border ports
+	sc_signal<bool >		ground;
+	sc_signal<regcredit >	ground_credit;
+	sc_signal<regcredit >	ground_no_credit;
+	sc_signal<regflit >		ground_data;
+	sc_signal<regvc >		ground_vc;
 		
-	pe  *	PE[N_PE];//store slaves PEs
+	pe  **	PE;//store slaves PEs
 	
 	int i,j;
 	
@@ -60,12 +66,28 @@ SC_MODULE(hemps) {
 	regaddress RouterAddress(int router);
 	regaddress r_addr;
  	void pes_interconnection();
+ 	void checkpoint(Checkpoint &ckp);
  	
 	char pe_name[20];
 	int x_addr, y_addr;
-	SC_CTOR(hemps){
-		
-		for (j = 0; j < N_PE; j++) {
+	SC_HAS_PROCESS(hemps);
+	hemps(sc_module_name name_, int n_pe_x_, int n_pe_y_, const NocConfig &noc = NocConfig()) :
+	sc_module(name_), n_pe_x(n_pe_x_), n_pe_y(n_pe_y_), n_pe(n_pe_x_*n_pe_y_)
+	{
+		mem_addr = new sc_out<sc_uint<30> >[n_pe];
+		data_read = new sc_in<sc_uint<32> >[n_pe];
+		ack_app = new sc_out<bool >[n_pe];
+		req_app = new sc_in<sc_uint<32> >[n_pe];
+
+		clock_tx = new sc_signal<bool >[n_pe][NPORT-1];
+		tx = new sc_signal<bool >[n_pe][NPORT-1];
+		data_out = new sc_signal<regflit >[n_pe][NPORT-1];
+		vc_out = new sc_signal<regvc >[n_pe][NPORT-1];
+		credit_o = new sc_signal<regcredit >[n_pe][NPORT-1];
+
+		PE = new pe*[n_pe];
+
+		for (j = 0; j < n_pe; j++) {
 
 			r_addr = RouterAddress(j);
 			x_addr = ((int) r_addr) >> 8;
@@ -74,7 +96,7 @@ SC_MODULE(hemps) {
 			sprintf(pe_name, "PE%dx%d", x_addr, y_addr);
 			printf("Creating PE %s\n", pe_name);
 
-			PE[j] = new pe(pe_name, r_addr);
+			PE[j] = new pe(pe_name, r_addr, noc);
 			PE[j]->clock(clock);
 			PE[j]->reset(reset);
 			PE[j]->address(mem_addr[j]);
@@ -86,27 +108,18 @@ SC_MODULE(hemps) {
 				PE[j]->clock_tx[i](clock_tx[j][i]);
 				PE[j]->tx[i](tx[j][i]);
 				PE[j]->data_out[i](data_out[j][i]);
-				PE[j]->credit_i[i](credit_i[j][i]);
-				PE[j]->clock_rx[i](clock_rx[j][i]);
-				PE[j]->data_in[i](data_in[j][i]);
-				PE[j]->rx[i](rx[j][i]);
+				PE[j]->vc_out[i](vc_out[j][i]);
 				PE[j]->credit_o[i](credit_o[j][i]);
 			}
 		}
 
-		SC_METHOD(pes_interconnection);
-		for (j = 0; j < N_PE; j++) {
-			for (i = 0; i < NPORT - 1; i++) {
-				sensitive << clock_tx[j][i];
-				sensitive << tx[j][i];
-				sensitive << data_out[j][i];
-				sensitive << credit_i[j][i];
-				sensitive << clock_rx[j][i];
-				sensitive << data_in[j][i];
-				sensitive << rx[j][i];
-				sensitive << credit_o[j][i];
-			}
-		}
+		ground.write(0);
+		ground_credit.write((1 << VC_MAX) - 1);
+		ground_no_credit.write(0);
+		ground_data.write(0);
+		ground_vc.write(0);
+
+		pes_interconnection();
 	}
 };
 
@@ -0,0 +1,121 @@
+/*
+ * image.h
+ *
+ *  Memory images of the repository, appstart and PE RAM files.
+ *
+ *  The build scripts write each image twice: the hex text file, one word per
+ *  line, used by the debugger tools, and a binary .img file that the
+ *  simulator maps read-only instead of parsing. The binary file is a 16 byte
+ *  header followed by the little-endian words:
+ *
+ *  	magic | version | number of words | CRC-32 of the words
+ *
+ *  A missing or invalid binary file falls back to the text file.
+ */
+
+#ifndef IMAGE_H_
+#define IMAGE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <vector>
+
+#define IMAGE_MAGIC		0x4D494D48	// "HMIM"
+#define IMAGE_VERSION	1
+
+class MemoryImage {
+public:
+	MemoryImage() : words(NULL), size(0), map_base(MAP_FAILED), map_size(0) {}
+
+	~MemoryImage() {
+		if (map_base != MAP_FAILED)
+			munmap(map_base, map_size);
+	}
+
+	// Maps a binary image. Returns false if it is missing or invalid
+	bool map(const char *path) {
+	#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+		return false;	// The words are stored little-endian
+	#endif
+		struct stat st;
+		int fd = open(path, O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		if (fstat(fd, &st) == 0 && st.st_size >= 16)
+			map_base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (map_base == MAP_FAILED)
+			return false;
+		map_size = st.st_size;
+
+		const uint32_t *header = (const uint32_t*)map_base;
+		if (header[0] != IMAGE_MAGIC || header[1] != IMAGE_VERSION || map_size != 16 + (size_t)header[2]*4 ||
+			crc32((const uint8_t*)&header[4], header[2]*4) != header[3]) {
+			munmap(map_base, map_size);
+			map_base = MAP_FAILED;
+			return false;
+		}
+
+		words = &header[4];
+		size = header[2];
+		return true;
+	}
+
+	// Parses a hex text image, one word per line
+	bool parse(const char *path) {
+		char line[256];
+		FILE *fp = fopen(path, "r");
+		if (fp == NULL)
+			return false;
+
+		while (fgets(line, sizeof(line), fp) != NULL) {
+			unsigned long word = 0;
+			line[8] = '\0';
+			sscanf(line, "%lx", &word);
+			text.push_back(word);
+		}
+		fclose(fp);
+
+		words = text.data();
+		size = text.size();
+		return true;
+	}
+
+	// Words past the end of the image read as zero
+	uint32_t operator[](unsigned int index) const {
+		return index < size ? words[index] : 0;
+	}
+
+	const uint32_t *words;
+	unsigned int size;
+
+private:
+	void *map_base;
+	size_t map_size;
+	std::vector<uint32_t> text;
+
+	static uint32_t crc32(const uint8_t *data, size_t length) {
+		static uint32_t table[256];
+		if (table[1] == 0) {
+			for (uint32_t i = 0; i < 256; i++) {
+				uint32_t c = i;
+				for (int k = 0; k < 8; k++)
+					c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+				table[i] = c;
+			}
+		}
+
+		uint32_t crc = 0xFFFFFFFF;
+		for (size_t i = 0; i < length; i++)
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		return crc ^ 0xFFFFFFFF;
+	}
+};
+
+#endif /* IMAGE_H_ */
@@ -0,0 +1,248 @@
+/*
+ * latency.h
+ *
+ *  End-to-end latency of the packets sent by the kernels.
+ *
+ *  A packet is identified by its target and by the source_PE and timestamp
+ *  fields of its service header, the address of the sender and the tick of
+ *  send_packet(). The simulator reads them from the flits crossing the local
+ *  ports and the routers, so the packets carry no extra flit and the platform
+ *  timing is unchanged. For each packet it collects, in ticks:
+ *
+ *  	queue		from send_packet() to the header leaving the DMNI of the sender
+ *  	hop			from the header entering a router to the header entering the next
+ *  	network		from the header leaving the sender to the last flit in the DMNI of the target
+ *  	delivery	from the last flit in the DMNI to the kernel reading it to memory
+ *  	total		from send_packet() to the kernel reading the last flit
+ *
+ *  report() writes, at the end of the simulation, the latencies of each
+ *  service to log_latency.csv and log_latency.json, with p50/p95/p99 and a
+ *  power of two histogram, and the latencies of each pair of source and
+ *  target to log_latency_matrix.csv.
+ *
+ *  Packets in flight are not saved in checkpoints: the packets of a restored
+ *  simulation are reported from the restore on.
+ */
+
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <iterator>
+
+// Flits of the service header that identify a packet
+#define LATENCY_SOURCE_FLIT		5
+#define LATENCY_TIMESTAMP_FLIT	6
+
+class Latency {
+public:
+	// Identifier of a packet
+	static uint64_t key(unsigned int source, unsigned int target, unsigned int timestamp) {
+		return ((uint64_t)(source & 0xFFFF) << 48) | ((uint64_t)(target & 0xFFFF) << 32) | timestamp;
+	}
+
+	// Header leaving the DMNI of the sender
+	static void inject(uint64_t key, unsigned int service, unsigned int tick) {
+		Packet &packet = instance().track(key, service);
+		packet.inject = tick;
+		packet.injected = true;
+	}
+
+	// Header entering a router, in the order of the path
+	static void hop(uint64_t key, unsigned int service, unsigned int tick) {
+		Packet &packet = instance().track(key, service);
+		if (packet.hops > 0)
+			instance().services[service].hop.add(tick - packet.last_hop);
+		packet.last_hop = tick;
+		packet.hops++;
+	}
+
+	// Last flit stored in the DMNI of the target
+	static void eject(uint64_t key, unsigned int service, unsigned int tick) {
+		Packet &packet = instance().track(key, service);
+		packet.eject = tick;
+		packet.ejected = true;
+	}
+
+	// Last flit written to memory by the DMNI of the target
+	static void consume(uint64_t key, unsigned int tick) {
+		Latency &latency = instance();
+		std::unordered_map<uint64_t, Packet>::iterator it = latency.packets.find(key);
+		if (it == latency.packets.end() || !it->second.ejected)
+			return;
+
+		Packet &packet = it->second;
+		unsigned int timestamp = key & 0xFFFFFFFF;
+		ServiceStats &service = latency.services[packet.service];
+		PairStats &pair = latency.pairs[key >> 32];
+
+		if (packet.injected) {
+			service.queue.add(packet.inject - timestamp);
+			service.network.add(packet.eject - packet.inject);
+			pair.injected++;
+			pair.network += packet.eject - packet.inject;
+		}
+		service.delivery.add(tick - packet.eject);
+		service.total.add(tick - timestamp);
+		service.hops += packet.hops;
+
+		pair.packets++;
+		pair.total += tick - timestamp;
+		pair.max_total = std::max(pair.max_total, tick - timestamp);
+
+		latency.packets.erase(it);
+	}
+
+	static void report() {
+		Latency &latency = instance();
+		const char *metrics[] = {"queue", "hop", "network", "delivery", "total"};
+		std::map<unsigned int, ServiceStats>::iterator s;
+		FILE *fp;
+
+		fp = fopen("log_latency.csv", "w");
+		if (fp != NULL) {
+			fprintf(fp, "service,metric,samples,mean,p50,p95,p99,max\n");
+			for (s = latency.services.begin(); s != latency.services.end(); s++) {
+				for (int m = 0; m < 5; m++) {
+					Samples &samples = s->second.metric(m);
+					fprintf(fp, "0x%x,%s,%lu,%.2f,%u,%u,%u,%u\n", s->first, metrics[m], (unsigned long)samples.values.size(),
+						samples.mean(), samples.percentile(50), samples.percentile(95), samples.percentile(99), samples.max);
+				}
+			}
+			fclose(fp);
+		}
+
+		fp = fopen("log_latency.json", "w");
+		if (fp != NULL) {
+			fprintf(fp, "{\n  \"unit\": \"ticks\",\n  \"in_flight\": %lu,\n  \"services\": [\n", (unsigned long)latency.packets.size());
+			for (s = latency.services.begin(); s != latency.services.end(); s++) {
+				fprintf(fp, "    {\"service\": \"0x%x\", \"packets\": %lu, \"hops\": %lu,\n", s->first,
+					(unsigned long)s->second.total.values.size(), s->second.hops);
+
+				for (int m = 0; m < 5; m++) {
+					Samples &samples = s->second.metric(m);
+					std::vector<unsigned long> histogram = samples.histogram();
+
+					fprintf(fp, "      \"%s\": {\"samples\": %lu, \"mean\": %.2f, \"p50\": %u, \"p95\": %u, \"p99\": %u, \"max\": %u, \"histogram\": [",
+						metrics[m], (unsigned long)samples.values.size(), samples.mean(), samples.percentile(50), samples.percentile(95),
+						samples.percentile(99), samples.max);
+					for (size_t b = 0; b < histogram.size(); b++)
+						fprintf(fp, "%s%lu", b ? ", " : "", histogram[b]);
+					fprintf(fp, "]}%s\n", m < 4 ? "," : "");
+				}
+
+				fprintf(fp, "    }%s\n", std::next(s) != latency.services.end() ? "," : "");
+			}
+			fprintf(fp, "  ]\n}\n");
+			fclose(fp);
+		}
+
+		fp = fopen("log_latency_matrix.csv", "w");
+		if (fp != NULL) {
+			fprintf(fp, "source_x,source_y,target_x,target_y,packets,mean_network,mean_total,max_total\n");
+			for (std::map<uint32_t, PairStats>::iterator p = latency.pairs.begin(); p != latency.pairs.end(); p++) {
+				PairStats &pair = p->second;
+				fprintf(fp, "%u,%u,%u,%u,%lu,%.2f,%.2f,%u\n", (p->first >> 24) & 0xFF, (p->first >> 16) & 0xFF, (p->first >> 8) & 0xFF,
+					p->first & 0xFF, pair.packets, pair.injected ? (double)pair.network / pair.injected : 0, (double)pair.total / pair.packets, pair.max_total);
+			}
+			fclose(fp);
+		}
+	}
+
+private:
+	struct Packet {
+		unsigned int service;
+		unsigned int inject, last_hop, eject;
+		unsigned int hops;
+		bool injected, ejected;
+	};
+
+	struct Samples {
+		std::vector<uint32_t> values;
+		uint64_t sum;
+		uint32_t max;
+
+		Samples() : sum(0), max(0) {}
+
+		void add(uint32_t value) {
+			values.push_back(value);
+			sum += value;
+			max = std::max(max, value);
+		}
+
+		double mean() { return values.empty() ? 0 : (double)sum / values.size(); }
+
+		// Nearest rank
+		uint32_t percentile(unsigned int p) {
+			if (values.empty())
+				return 0;
+			size_t rank = (values.size() * p + 99) / 100;
+			std::nth_element(values.begin(), values.begin() + (rank - 1), values.end());
+			return values[rank - 1];
+		}
+
+		// Bin 0 counts 0, bin b counts the values from 2^(b-1) to 2^b - 1
+		std::vector<unsigned long> histogram() {
+			std::vector<unsigned long> bins;
+			for (size_t i = 0; i < values.size(); i++) {
+				unsigned int b = 0;
+				while (b < 32 && (values[i] >> b) != 0)
+					b++;
+				if (bins.size() <= b)
+					bins.resize(b + 1, 0);
+				bins[b]++;
+			}
+			return bins;
+		}
+	};
+
+	struct ServiceStats {
+		Samples queue, hop, network, delivery, total;
+		unsigned long hops;
+
+		ServiceStats() : hops(0) {}
+
+		Samples &metric(int m) {
+			Samples *metrics[] = {&queue, &hop, &network, &delivery, &total};
+			return *metrics[m];
+		}
+	};
+
+	// Packets of a source and target, key source << 16 | target
+	struct PairStats {
+		unsigned long packets, injected;
+		uint64_t network, total;
+		uint32_t max_total;
+
+		PairStats() : packets(0), injected(0), network(0), total(0), max_total(0) {}
+	};
+
+	std::unordered_map<uint64_t, Packet> packets;	// In flight
+	std::map<unsigned int, ServiceStats> services;
+	std::map<uint32_t, PairStats> pairs;
+
+	static Latency &instance() {
+		static Latency latency;
+		return latency;
+	}
+
+	// The DMNI of the sender and its router see the header on the same clock edge, in any order
+	Packet &track(uint64_t key, unsigned int service) {
+		std::pair<std::unordered_map<uint64_t, Packet>::iterator, bool> it = packets.insert(std::make_pair(key, Packet()));
+		if (it.second) {
+			Packet &packet = it.first->second;
+			packet.service = service;
+			packet.inject = packet.last_hop = packet.eject = 0;
+			packet.hops = 0;
+			packet.injected = packet.ejected = false;
+		}
+		return it.first->second;
+	}
+};
+
+#endif /* LATENCY_H_ */
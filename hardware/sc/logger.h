@@ -0,0 +1,258 @@
+/*
+ * logger.h
+ *
+ *  Buffered logging of the text files written by the simulated platform.
+ *
+ *  Writers append to the memory buffer of a log and a host thread drains the
+ *  buffers to the files, appending each batch with a single write(2) loop. The
+ *  bytes reach each file in the order they were written, so the files are the
+ *  same as when every write opened, appended and closed the file.
+ *
+ *  A file is opened at the first drain of its log. At most LOG_MAX_OPEN_FILES
+ *  files stay open between drains, the others are closed after each batch, so
+ *  large meshes with three logs per PE stay within the open-file limit. If a
+ *  file cannot be opened or written, the batch is kept and retried at the next
+ *  drain, and the error is reported once on stderr.
+ *
+ *  The buffers are drained at exit and at the end of the simulation. On
+ *  crash signals the handler drains, with write(2) only, the logs no thread
+ *  is using and whose file is open; the others are left as they are.
+ *  SIGINT and SIGTERM are not handled here: the test bench stops the
+ *  simulation and the logs are drained by the normal path.
+ */
+
+#ifndef LOGGER_H_
+#define LOGGER_H_
+
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+
+#define LOG_DRAIN_BYTES		(64*1024)	// Wakes the drain thread
+#define LOG_MAX_BYTES		(1024*1024)	// The writer drains the log itself
+#define LOG_DRAIN_PERIOD_MS	100
+#define LOG_MAX_OPEN_FILES	64			// Files kept open between drains
+
+class Logger {
+public:
+	class Log {
+	public:
+		Log(const std::string &path_) : path(path_), fd(-1), reported(false), users(0) {}
+
+		void write(const char *data, size_t size) {
+			size_t buffered;
+			users++;
+			{
+				std::lock_guard<std::mutex> lock(buffer_mutex);
+				buffer.append(data, size);
+				buffered = buffer.size();
+			}
+			users--;
+
+			if (buffered >= LOG_MAX_BYTES)
+				drain(true);
+			else if (buffered >= LOG_DRAIN_BYTES)
+				Logger::instance().wake();
+		}
+
+		void write(const char *text) { write(text, strlen(text)); }
+
+		// Appends the buffer to the file. Without wait, gives up if another drain holds the file
+		void drain(bool wait) {
+			users++;
+			std::unique_lock<std::mutex> file_lock(file_mutex, std::defer_lock);
+			if (wait)
+				file_lock.lock();
+			else if (!file_lock.try_lock()) {
+				users--;
+				return;
+			}
+
+			{
+				// pending still holds what a failed drain could not write, which goes first
+				std::lock_guard<std::mutex> lock(buffer_mutex);
+				pending.append(buffer);
+				buffer.clear();
+			}
+
+			if (!pending.empty()) {
+				if (fd < 0) {	// The directory may be created after the log
+					fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+					if (fd >= 0)
+						Logger::instance().open_files++;
+					else
+						report("open");
+				}
+
+				if (fd >= 0) {
+					size_t written = append(fd, pending.data(), pending.size());
+					if (written < pending.size())
+						report("write");
+					pending.erase(0, written);
+
+					if (Logger::instance().open_files.load() > LOG_MAX_OPEN_FILES) {
+						::close(fd);
+						fd = -1;
+						Logger::instance().open_files--;
+					}
+				}
+			}
+
+			file_lock.unlock();
+			users--;
+		}
+
+		// From a signal handler: skips the log if a thread, maybe the interrupted one, is using it,
+		// or if its file is not open, as opening it is not safe there
+		void crash_drain() {
+			if (users.load() != 0 || !file_mutex.try_lock())
+				return;
+			if (fd >= 0 && buffer_mutex.try_lock()) {
+				if (append(fd, pending.data(), pending.size()) == pending.size())
+					append(fd, buffer.data(), buffer.size());
+				buffer_mutex.unlock();
+			}
+			file_mutex.unlock();
+		}
+
+		// Bytes not written to the file yet, reported at the end of the simulation
+		size_t unwritten() {
+			std::lock_guard<std::mutex> file_lock(file_mutex);
+			std::lock_guard<std::mutex> lock(buffer_mutex);
+			return pending.size() + buffer.size();
+		}
+
+		const std::string &name() { return path; }
+
+	private:
+		std::string path;
+		int fd;				// Open between drains only while the file cache has room
+		bool reported;		// An open or write error was reported for this file
+		std::string buffer, pending;
+		std::mutex buffer_mutex, file_mutex;	// file_mutex keeps the drains of a log in order
+		std::atomic<int> users;					// Threads in write() or drain(), taken before the mutexes
+
+		// Returns the bytes written, less than size on an error
+		static size_t append(int fd, const char *data, size_t size) {
+			size_t done = 0;
+			while (done < size) {
+				ssize_t written = ::write(fd, data + done, size - done);
+				if (written < 0 && errno == EINTR)
+					continue;
+				if (written <= 0)
+					break;
+				done += written;
+			}
+			return done;
+		}
+
+		void report(const char *operation) {
+			if (reported)
+				return;
+			reported = true;
+			fprintf(stderr, "WARNING: Unable to %s log file %s: %s. Its data is kept and retried\n",
+				operation, path.c_str(), strerror(errno));
+		}
+	};
+
+	// The log of a file, created on its first use
+	static Log *open(const char *path) {
+		Logger &logger = instance();
+		logger.opening++;
+		std::lock_guard<std::mutex> lock(logger.logs_mutex);
+
+		Log *&log = logger.logs[path];
+		if (log == NULL)
+			log = new Log(path);
+		logger.opening--;
+		return log;
+	}
+
+	static void flush() { instance().drain_all(); }
+
+private:
+	std::map<std::string, Log*> logs;
+	std::mutex logs_mutex;
+	std::atomic<int> opening;	// Threads changing logs, which the crash handler reads without the mutex
+	std::atomic<int> open_files;	// Log files open between drains
+	std::thread drainer;
+	std::condition_variable wakeup;
+	std::mutex wakeup_mutex;
+	bool running;
+
+	static Logger &instance() {
+		static Logger logger;
+		return logger;
+	}
+
+	Logger() : opening(0), open_files(0), running(true) {
+		drainer = std::thread(&Logger::drain_loop, this);
+
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_handler = crash;
+		action.sa_flags = SA_RESETHAND;
+		sigemptyset(&action.sa_mask);
+
+		sigaction(SIGSEGV, &action, NULL);
+		sigaction(SIGBUS, &action, NULL);
+		sigaction(SIGFPE, &action, NULL);
+		sigaction(SIGABRT, &action, NULL);
+	}
+
+	~Logger() {
+		{
+			std::lock_guard<std::mutex> lock(wakeup_mutex);
+			running = false;
+		}
+		wakeup.notify_one();
+		drainer.join();
+		drain_all();
+
+		for (std::map<std::string, Log*>::iterator it = logs.begin(); it != logs.end(); it++) {
+			size_t lost = it->second->unwritten();
+			if (lost > 0)
+				fprintf(stderr, "ERROR: %lu bytes of log file %s were not written\n", (unsigned long)lost, it->second->name().c_str());
+		}
+	}
+
+	void wake() { wakeup.notify_one(); }
+
+	void drain_all() {
+		std::lock_guard<std::mutex> lock(logs_mutex);
+		for (std::map<std::string, Log*>::iterator it = logs.begin(); it != logs.end(); it++)
+			it->second->drain(true);
+	}
+
+	void drain_loop() {
+		std::unique_lock<std::mutex> lock(wakeup_mutex);
+		while (running) {
+			wakeup.wait_for(lock, std::chrono::milliseconds(LOG_DRAIN_PERIOD_MS));
+			lock.unlock();
+			drain_all();
+			lock.lock();
+		}
+	}
+
+	// Best effort, only write(2) and try_lock. The handler is reset by SA_RESETHAND
+	static void crash(int sig) {
+		Logger &logger = instance();
+		if (logger.opening.load() == 0) {
+			for (std::map<std::string, Log*>::iterator it = logger.logs.begin(); it != logger.logs.end(); it++)
+				it->second->crash_drain();
+		}
+		raise(sig);
+	}
+};
+
+#endif /* LOGGER_H_ */
@@ -0,0 +1,149 @@
+/*
+ * noc_bench.cpp
+ *
+ *  Traffic sources and sinks of the NoC bench.
+ */
+
+#include "noc_bench.h"
+
+bool noc_bench::load_platform(){
+
+	string json;
+
+	if (!read_platform(json) || !load_mesh(json, n_pe_x, n_pe_y) || !load_noc_config(json, noc))
+		return false;
+
+	n_pe = n_pe_x * n_pe_y;
+
+	return true;
+}
+
+// Queues a packet at the source, to a uniform random target other than itself
+void noc_bench::new_packet(unsigned int source){
+
+	vector<unsigned int> flits;
+	unsigned int target, payload, i;
+
+	if (n_pe < 2)
+		return;
+
+	do {
+		target = generator() % n_pe;
+	} while (target == source);
+
+	payload = (generator() % 2) ? 32 + generator() % 96 : 0;
+
+	flits.push_back(((target % n_pe_x) << 8) | (target / n_pe_x));
+	flits.push_back(BENCH_HEADER_SIZE - 2 + payload);
+	for (i = 2; i < BENCH_HEADER_SIZE + payload; i++)
+		flits.push_back(generator() & 0xFFFF);
+
+	flits[2] = payload ? BENCH_DELIVERY : BENCH_REQUEST;
+	flits[LATENCY_SOURCE_FLIT] = ((source % n_pe_x) << 8) | (source / n_pe_x);
+	flits[LATENCY_TIMESTAMP_FLIT] = cycle;
+
+	in_flight[Latency::key(flits[LATENCY_SOURCE_FLIT], flits[0], cycle)] = flits;
+	send_queue[source].push_back(flits);
+	sent++;
+}
+
+// Flit taken from the LOCAL output of the router. Checks the packet once its last flit arrives
+void noc_bench::receive(unsigned int target, unsigned int flit){
+
+	vector<unsigned int> &flits = recv_flits[target];
+
+	flits.push_back(flit);
+	if (flits.size() < 2 || flits.size() < flits[1] + 2)
+		return;
+
+	if (flits.size() <= LATENCY_TIMESTAMP_FLIT) {
+		corrupted++;
+		flits.clear();
+		return;
+	}
+
+	uint64_t key = Latency::key(flits[LATENCY_SOURCE_FLIT], flits[0], flits[LATENCY_TIMESTAMP_FLIT]);
+	unordered_map<uint64_t, vector<unsigned int> >::iterator packet = in_flight.find(key);
+
+	if (packet == in_flight.end() || packet->second != flits || (flits[0] & 0xFFFF) != (((target % n_pe_x) << 8) | (target / n_pe_x))) {
+		corrupted++;
+	} else {
+		Latency::eject(key, flits[2], cycle);
+		Latency::consume(key, cycle);
+		in_flight.erase(packet);
+		delivered++;
+	}
+
+	flits.clear();
+}
+
+// Registered like the DMNI: the flits taken on this edge are the ones driven on the previous one
+void noc_bench::traffic(){
+
+	unsigned int r, local;
+
+	cycle++;
+	tick_counter.write(cycle);
+
+	if (cycle <= BENCH_RESET_CYCLES) {
+		reset_n.write(0);
+		return;
+	}
+	reset_n.write(1);
+
+	for (r = 0; r < n_pe; r++) {
+		local = r*NPORT + LOCAL;
+
+		if (source_tx[r].read() == 1 && credit_o[local].read() == 1) {
+			vector<unsigned int> &flits = send_queue[r].front();
+
+			if (send_flit[r] == 0)
+				send_header_time[r] = (unsigned int)tick_counter.read();
+			if (send_flit[r] == LATENCY_TIMESTAMP_FLIT)
+				Latency::inject(Latency::key(flits[LATENCY_SOURCE_FLIT], flits[0], flits[LATENCY_TIMESTAMP_FLIT]), flits[2], send_header_time[r]);
+
+			if (++send_flit[r] == flits.size()) {
+				send_queue[r].pop_front();
+				send_flit[r] = 0;
+			}
+		}
+
+		if (tx[local].read() == 1 && sink_credit[r].read() == 1)
+			receive(r, (unsigned int)data_out[local].read());
+
+		if (cycle <= BENCH_RESET_CYCLES + traffic_cycles && generator() % 1000 < rate)
+			new_packet(r);
+
+		if (send_queue[r].empty()) {
+			source_tx[r].write(0);
+		} else {
+			source_tx[r].write(1);
+			source_data[r].write(send_queue[r].front()[send_flit[r]]);
+		}
+
+		sink_credit[r].write((backpressure && generator() % 100 < backpressure) ? 0 : 1);
+	}
+
+	if (cycle > BENCH_RESET_CYCLES + traffic_cycles) {
+		if (delivered + corrupted == sent) {
+			sc_stop();
+		} else if (cycle > BENCH_RESET_CYCLES + traffic_cycles + BENCH_DRAIN_CYCLES) {
+			deadlock = true;
+			sc_stop();
+		}
+	}
+}
+
+void noc_bench::report(){
+
+	cout << "NoC bench: " << n_pe_x << "x" << n_pe_y << " routers, " << noc.vcs << " VCs, routing " << noc.routing
+		 << ", buffers of " << noc.buffer_depth << " flits, " << rate << " packets per PE per 1000 cycles" << endl;
+	cout << "Packets sent " << sent << ", delivered " << delivered << ", corrupted " << corrupted
+		 << ", cycles " << cycle - BENCH_RESET_CYCLES << endl;
+
+	if (deadlock)
+		cout << "ERROR: " << sent - delivered - corrupted << " packets not delivered " << BENCH_DRAIN_CYCLES << " cycles after the traffic" << endl;
+
+	Latency::report();
+	cout << "Latencies of each service in log_latency.csv and log_latency.json" << endl;
+}
@@ -0,0 +1,226 @@
+/*
+ * noc_bench.h
+ *
+ *  Synthetic traffic bench of the router mesh, without the PEs.
+ *
+ *  The mesh size, buffers, virtual channels and routing come from
+ *  include/platform.json, so the bench runs the NoC of a testcase. A traffic
+ *  source and a sink take the place of the DMNI at the LOCAL port of each
+ *  router. Every cycle of traffic, a source starts a packet with probability
+ *  rate/1000 to a uniform random target. The packets have the service header
+ *  of the kernel, with the source and timestamp flits read by the latency
+ *  trace: half are a MESSAGE_REQUEST with no payload and half a
+ *  MESSAGE_DELIVERY with 32 to 127 payload flits.
+ *
+ *  The sinks check every flit against the packet sent. At the end the queue,
+ *  hop and network latencies of each service are written to log_latency.csv
+ *  and log_latency.json, as in a platform run.
+ *
+ *  Built with make -C hardware noc_bench and run from the testcase directory:
+ *  	noc_bench -c <cycles of traffic> -r <packets per PE per 1000 cycles> [-s <seed>] [-b <percent of cycles the sinks refuse flits>]
+ */
+
+#ifndef NOC_BENCH_H_
+#define NOC_BENCH_H_
+
+#include <systemc.h>
+#include <iostream>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+#include <random>
+
+using namespace std;
+
+#include "platform.h"
+#include "latency.h"
+#include "pe/router/router_cc.h"
+
+#define BENCH_RESET_CYCLES		4
+#define BENCH_DRAIN_CYCLES		100000	// Cycles after the traffic to deliver the last packets, else the NoC is deadlocked
+#define BENCH_REQUEST			0x10	// MESSAGE_REQUEST and MESSAGE_DELIVERY of software/include/services.h
+#define BENCH_DELIVERY			0x20
+#define BENCH_HEADER_SIZE		13		// Flits of the service header, with the target and size flits
+
+SC_MODULE(noc_bench) {
+
+	sc_clock					clock;
+	sc_signal<bool >			reset_n;
+	sc_signal<sc_uint<32 > >	tick_counter;
+
+	// Mesh links, router*NPORT + port
+	sc_signal<regflit >			*data_out;
+	sc_signal<regvc >			*vc_out;
+	sc_signal<bool >			*clock_tx;
+	sc_signal<bool >			*tx;
+	sc_signal<regcredit >		*credit_o;
+
+	sc_signal<bool >			ground;
+	sc_signal<regcredit >		ground_no_credit;
+	sc_signal<regflit >			ground_data;
+	sc_signal<regvc >			ground_vc;
+
+	// LOCAL ports, one per router
+	sc_signal<bool >			*source_tx;
+	sc_signal<regflit >			*source_data;
+	sc_signal<regcredit >		*sink_credit;
+
+	router_cc					**router;
+
+	unsigned int n_pe_x, n_pe_y, n_pe;
+	NocConfig noc;
+	bool load_platform();
+
+	// Traffic
+	unsigned int traffic_cycles, rate, backpressure;
+	mt19937 generator;
+	unsigned int cycle;
+	vector<deque<vector<unsigned int> > > send_queue;
+	vector<unsigned int> send_flit, send_header_time;
+	vector<vector<unsigned int> > recv_flits;
+	unordered_map<uint64_t, vector<unsigned int> > in_flight;	// Packets sent, by their latency key
+	unsigned long sent, delivered, corrupted;
+	bool deadlock;
+
+	void new_packet(unsigned int source);
+	void receive(unsigned int target, unsigned int flit);
+	void traffic();
+	void report();
+
+	SC_HAS_PROCESS(noc_bench);
+	noc_bench(sc_module_name name_, unsigned int traffic_cycles_, unsigned int rate_, unsigned int seed_, unsigned int backpressure_) :
+	sc_module(name_), clock("clock", CLOCK_PERIOD_NS, SC_NS), traffic_cycles(traffic_cycles_), rate(rate_), backpressure(backpressure_), generator(seed_)
+	{
+		unsigned int r, p;
+
+		if (!load_platform())
+			exit(EXIT_FAILURE);
+
+		data_out = new sc_signal<regflit >[n_pe * NPORT];
+		vc_out = new sc_signal<regvc >[n_pe * NPORT];
+		clock_tx = new sc_signal<bool >[n_pe * NPORT];
+		tx = new sc_signal<bool >[n_pe * NPORT];
+		credit_o = new sc_signal<regcredit >[n_pe * NPORT];
+
+		source_tx = new sc_signal<bool >[n_pe];
+		source_data = new sc_signal<regflit >[n_pe];
+		sink_credit = new sc_signal<regcredit >[n_pe];
+
+		ground.write(0);
+		ground_no_credit.write(0);
+		ground_data.write(0);
+		ground_vc.write(0);
+
+		router = new router_cc*[n_pe];
+		for (r = 0; r < n_pe; r++) {
+			char name[20];
+			unsigned int x = r % n_pe_x, y = r / n_pe_x;
+
+			sprintf(name, "router%d", r);
+			router[r] = new router_cc(name, (x << 8) | y, noc);
+			router[r]->clock(clock);
+			router[r]->reset_n(reset_n);
+			router[r]->tick_counter(tick_counter);
+
+			for (p = 0; p < NPORT; p++) {
+				router[r]->data_out[p](data_out[r*NPORT + p]);
+				router[r]->vc_out[p](vc_out[r*NPORT + p]);
+				router[r]->clock_tx[p](clock_tx[r*NPORT + p]);
+				router[r]->tx[p](tx[r*NPORT + p]);
+				router[r]->credit_o[p](credit_o[r*NPORT + p]);
+			}
+
+			// Each input is bound to the output of the neighbour, the border inputs to the ground
+			for (p = 0; p < NPORT; p++) {
+				int neighbour = -1;
+
+				if (p == EAST && x < n_pe_x - 1)
+					neighbour = (r + 1) * NPORT + WEST;
+				else if (p == WEST && x > 0)
+					neighbour = (r - 1) * NPORT + EAST;
+				else if (p == NORTH && y < n_pe_y - 1)
+					neighbour = (r + n_pe_x) * NPORT + SOUTH;
+				else if (p == SOUTH && y > 0)
+					neighbour = (r - n_pe_x) * NPORT + NORTH;
+
+				if (p == LOCAL) {
+					router[r]->rx[p](source_tx[r]);
+					router[r]->data_in[p](source_data[r]);
+					router[r]->vc_in[p](ground_vc);
+					router[r]->clock_rx[p](ground);
+					router[r]->credit_i[p](sink_credit[r]);
+				} else if (neighbour < 0) {
+					router[r]->rx[p](ground);
+					router[r]->data_in[p](ground_data);
+					router[r]->vc_in[p](ground_vc);
+					router[r]->clock_rx[p](ground);
+					router[r]->credit_i[p](ground_no_credit);
+				} else {
+					router[r]->rx[p](tx[neighbour]);
+					router[r]->data_in[p](data_out[neighbour]);
+					router[r]->vc_in[p](vc_out[neighbour]);
+					router[r]->clock_rx[p](clock_tx[neighbour]);
+					router[r]->credit_i[p](credit_o[neighbour]);
+				}
+			}
+		}
+
+		cycle = 0;
+		sent = 0;
+		delivered = 0;
+		corrupted = 0;
+		deadlock = false;
+		send_queue.resize(n_pe);
+		send_flit.resize(n_pe, 0);
+		send_header_time.resize(n_pe, 0);
+		recv_flits.resize(n_pe);
+
+		SC_METHOD(traffic);
+		sensitive << clock.posedge_event();
+		dont_initialize();
+	}
+};
+
+#ifndef MTI_SYSTEMC
+
+int sc_main(int argc, char *argv[]){
+
+	unsigned int traffic_cycles = 0, rate = 0, seed = 1, backpressure = 0;
+	int i;
+
+	for (i = 1; i < argc - 1; i++){
+		if (argv[i][0] == '-') {
+			switch (argv[i][1]){
+				case 'c':
+					traffic_cycles = atoi(argv[++i]);
+				break;
+				case 'r':
+					rate = atoi(argv[++i]);
+				break;
+				case 's':
+					seed = atoi(argv[++i]);
+				break;
+				case 'b':
+					backpressure = atoi(argv[++i]);
+				break;
+			}
+		}
+	}
+
+	if (traffic_cycles == 0 || rate == 0 || rate > 1000 || backpressure >= 100){
+		cout << "Sintax: " << argv[0] << " -c <cycles of traffic> -r <packets per PE per 1000 cycles> [-s <seed>] [-b <percent of cycles the sinks refuse flits>]" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	noc_bench bench("noc_bench", traffic_cycles, rate, seed, backpressure);
+
+	sc_start();
+
+	bench.report();
+
+	return (bench.deadlock || bench.corrupted || bench.delivered != bench.sent) ? EXIT_FAILURE : 0;
+}
+
+#endif
+
+#endif /* NOC_BENCH_H_ */
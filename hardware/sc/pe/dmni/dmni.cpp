@@ -137,7 +137,9 @@ void dmni::receive(){
 		intr_count.write(0);
 		for(int i=0; i<BUFFER_SIZE; i++){ //in vhdl replace by OTHERS=>'0'
 			is_header[i] = 0;
+			recv_tail[i] = false;
 		}
+		recv_flit = 0;
 	} else {
 
 		intr_counter_temp = intr_count.read();
@@ -146,6 +148,7 @@ void dmni::receive(){
 		if (rx.read() == 1 && slot_available.read() == 1){
 
 			buffer[last.read()].write(data_in.read());
+			latency_receive((unsigned int)data_in.read(), last.read());
 			add_buffer.write(1);
 			last.write(last.read() + 1);
 
@@ -199,6 +202,10 @@ void dmni::receive(){
 					mem_byte_we.write(0xF);
 
 					mem_data_write.write(buffer[first.read()].read());
+					if (recv_tail[first.read()]){
+						Latency::consume(recv_key[first.read()], (unsigned int)tick_counter.read());
+						recv_tail[first.read()] = false;
+					}
 					first.write(first.read() + 1);
 					add_buffer.write(0);
 					recv_address.write(recv_address.read() + WORD_SIZE);
@@ -241,8 +248,14 @@ void dmni::send(){
 		DMNI_Send.write(WAIT);
 		send_active.write(0);
 		tx.write(0);
+		send_flit = 0;
 	} else {
 
+		//Flit taken by the router on this edge
+		if (tx.read() == 1 && credit_i.read() == 1){
+			latency_send((unsigned int)data_out.read());
+		}
+
 		switch (DMNI_Send.read()) {
 			case WAIT:
 				if (start.read() == 1 && operation.read() == 0){
@@ -322,3 +335,120 @@ void dmni::send(){
 	}
 
 }
+
+//Identifies the packets sent from the header flits taken by the router
+void dmni::latency_send(unsigned int flit){
+
+	switch (send_flit) {
+		case 0:
+			send_target = flit & 0xFFFF;
+			send_header_time = (unsigned int)tick_counter.read();
+		break;
+		case 1:
+			send_payload = flit;
+		break;
+		case 2:
+			send_service = flit;
+		break;
+		case LATENCY_SOURCE_FLIT:
+			send_source = flit;
+		break;
+		case LATENCY_TIMESTAMP_FLIT:
+			Latency::inject(Latency::key(send_source, send_target, flit), send_service, send_header_time);
+		break;
+	}
+
+	if (send_flit >= 1 && send_flit >= send_payload + 1){
+		send_flit = 0;
+	} else {
+		send_flit++;
+	}
+}
+
+//Identifies the packets received, tagging the buffer slot of the last flit
+void dmni::latency_receive(unsigned int flit, unsigned int slot){
+
+	switch (recv_flit) {
+		case 0:
+			recv_target = flit & 0xFFFF;
+		break;
+		case 1:
+			recv_payload = flit;
+		break;
+		case 2:
+			recv_service = flit;
+		break;
+		case LATENCY_SOURCE_FLIT:
+			recv_source = flit;
+		break;
+		case LATENCY_TIMESTAMP_FLIT:
+			recv_packet = Latency::key(recv_source, recv_target, flit);
+		break;
+	}
+
+	recv_tail[slot] = false;
+
+	if (recv_flit >= 1 && recv_flit >= recv_payload + 1){
+		//Packets shorter than the service header are not tracked
+		if (recv_flit >= LATENCY_TIMESTAMP_FLIT){
+			recv_key[slot] = recv_packet;
+			recv_tail[slot] = true;
+			Latency::eject(recv_packet, recv_service, (unsigned int)tick_counter.read());
+		}
+		recv_flit = 0;
+	} else {
+		recv_flit++;
+	}
+}
+
+//No transfer in progress and nothing buffered
+bool dmni::idle(){
+	return DMNI_Send.read() == WAIT && DMNI_Receive.read() == WAIT && ARB.read() == ROUND && SR.read() == HEADER &&
+		read_av.read() == 0 && intr_count.read() == 0 && rx.read() == 0;
+}
+
+void dmni::checkpoint(Checkpoint &ckp){
+
+	ckp.io(DMNI_Send);
+	ckp.io(DMNI_Receive);
+	ckp.io(SR);
+	ckp.io(ARB);
+	ckp.io(buffer);
+	ckp.io(is_header);
+	ckp.io(intr_count);
+	ckp.io(first);
+	ckp.io(last);
+	ckp.io(add_buffer);
+	ckp.io(payload_size);
+	ckp.io(timer);
+	ckp.io(address);
+	ckp.io(address_2);
+	ckp.io(size);
+	ckp.io(size_2);
+	ckp.io(send_address);
+	ckp.io(send_address_2);
+	ckp.io(send_size);
+	ckp.io(send_size_2);
+	ckp.io(recv_address);
+	ckp.io(recv_size);
+	ckp.io(prio);
+	ckp.io(operation);
+	ckp.io(read_av);
+	ckp.io(slot_available);
+	ckp.io(write_enable);
+	ckp.io(read_enable);
+	ckp.io(send_flit);
+	ckp.io(send_payload);
+	ckp.io(send_target);
+	ckp.io(send_service);
+	ckp.io(send_source);
+	ckp.io(send_header_time);
+	ckp.io(recv_flit);
+	ckp.io(recv_payload);
+	ckp.io(recv_target);
+	ckp.io(recv_service);
+	ckp.io(recv_source);
+	ckp.io(recv_packet);
+	ckp.io(recv_tail);
+	ckp.io(recv_key);
+}
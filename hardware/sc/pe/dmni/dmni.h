@@ -17,6 +17,7 @@
 
 #include <systemc.h>
 #include "../../standards.h"
+#include "../../latency.h"
 
 /*
  * send - read from memory and write to noc
@@ -53,13 +54,15 @@ SC_MODULE(dmni){
 	// NoC Interface (Local port)
 	sc_out<bool > 				tx;
 	sc_out<regflit > 			data_out;
-	sc_in<bool > 				credit_i;
+	sc_in<regcredit > 			credit_i;	// The LOCAL port has only VC 0
 	sc_out<bool > 				clock_tx;
 	sc_in<bool > 				rx;
 	sc_in<regflit >				data_in;
-	sc_out<bool > 				credit_o;
+	sc_out<regcredit > 			credit_o;
 	sc_in<bool > 				clock_rx;
 
+	sc_in<sc_uint<32 > >		tick_counter;
+
 	enum dmni_state				{WAIT, LOAD, COPY_FROM_MEM, COPY_TO_MEM, END};
 	sc_signal<dmni_state >		DMNI_Send, DMNI_Receive;
 
@@ -97,6 +100,15 @@ SC_MODULE(dmni){
 	sc_signal<bool >            write_enable;
 	sc_signal<bool >            read_enable;
 
+	//Latency tracking: flits of the packets crossing the local port, see latency.h
+	unsigned int send_flit, send_payload, send_target, send_service, send_source, send_header_time;
+	unsigned int recv_flit, recv_payload, recv_target, recv_service, recv_source;
+	uint64_t recv_packet;
+	bool recv_tail[BUFFER_SIZE];		// Last flit of a tracked packet, reported when written to memory
+	uint64_t recv_key[BUFFER_SIZE];
+	void latency_send(unsigned int flit);
+	void latency_receive(unsigned int flit, unsigned int slot);
+
 	void config();
 	void receive();
 	void send();
@@ -104,6 +116,8 @@ SC_MODULE(dmni){
 	void arbiter();
 	void credit_o_update();
 	void mem_address_update();
+	bool idle();
+	void checkpoint(Checkpoint &ckp);
 	
 	SC_HAS_PROCESS(dmni);
 	dmni(sc_module_name name_, regmetadeflit address_router_ = 0) :
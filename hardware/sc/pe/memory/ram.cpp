@@ -13,37 +13,85 @@
 //------------------------------------------------------------------------------------------------
 
 #include "ram.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <map>
+#include <vector>
 
 #ifdef MTI_SYSTEMC
 SC_MODULE_EXPORT(ram);
 #endif
 
-void ram::load_ram(){
+/*** Shared RAM images ***/
+// Pages of each ram image already loaded, by real path. The slave PEs link to the same kernel
+// image, so it is loaded once and its pages are shared until a PE writes to them
+static map<string, vector<uint32_t*> > images;
+static uint32_t zero_page[RAM_PAGE_WORDS];
+
+static vector<uint32_t*> load_image(const char *img_path, const char *txt_path){
 
-	string line;
-	int i = 0;
+	vector<uint32_t*> pages(RAM_PAGES, zero_page);
 
-	char ram_path[20];
-	sprintf(ram_path, "ram_pe/ram%dx%d.txt", (router_address >> 8), (router_address & 0xFF));
-	ifstream repo_file (ram_path);
+	// Kept for the whole simulation, the pages point into it
+	MemoryImage *image = new MemoryImage();
 
-	if (repo_file.is_open()) {
-		while ( getline (repo_file,line) ) {
+	if (!image->map(img_path) && !image->parse(txt_path)) {
+		cout << "Unable to open file " << txt_path << endl;
+		return pages;
+	}
 
-			if (i == RAM_SIZE){
-				cout << "ERROR: Ram file "<< ram_path << "is greater than RAM_SIZE = " << RAM_SIZE << endl;
-				sc_stop();
-			}
+	if (image->size > RAM_SIZE){
+		cout << "ERROR: Ram file "<< txt_path << "is greater than RAM_SIZE = " << RAM_SIZE << endl;
+		sc_stop();
+		return pages;
+	}
 
-			//Converts a hex string to unsigned integer
-			sscanf( line.substr(0, 8).c_str(), "%lx", &ram_data[i] );
-			i++;
+	for (unsigned int p = 0; p * RAM_PAGE_WORDS < image->size; p++){
+		unsigned int words = image->size - p * RAM_PAGE_WORDS;
 
+		if (words >= RAM_PAGE_WORDS){
+			pages[p] = (uint32_t*)&image->words[p * RAM_PAGE_WORDS];
+		} else {	// The last page is only partially in the image
+			pages[p] = new uint32_t[RAM_PAGE_WORDS]();
+			memcpy(pages[p], &image->words[p * RAM_PAGE_WORDS], words * sizeof(uint32_t));
 		}
-		repo_file.close();
-	} else {
-		cout << "Unable to open file " << ram_path << endl;
 	}
+
+	return pages;
+}
+
+void ram::load_ram(){
+
+	char img_path[32], txt_path[32];
+	char real_path[PATH_MAX];
+	sprintf(img_path, "ram_pe/ram%dx%d.img", (router_address >> 8), (router_address & 0xFF));
+	sprintf(txt_path, "ram_pe/ram%dx%d.txt", (router_address >> 8), (router_address & 0xFF));
+
+	string key;
+	if (realpath(img_path, real_path) != NULL || realpath(txt_path, real_path) != NULL)
+		key = real_path;
+	else
+		key = txt_path;
+
+	map<string, vector<uint32_t*> >::iterator image = images.find(key);
+	if (image == images.end())
+		image = images.insert(make_pair(key, load_image(img_path, txt_path))).first;
+
+	for (unsigned int p = 0; p < RAM_PAGES; p++){
+		pages[p] = image->second[p];
+		shared[p] = true;
+	}
+}
+
+/*** Gives the PE its own copy of a shared page ***/
+void ram::copy_page(unsigned int page){
+
+	uint32_t *copy = new uint32_t[RAM_PAGE_WORDS];
+	memcpy(copy, pages[page], RAM_PAGE_WORDS * sizeof(uint32_t));
+
+	pages[page] = copy;
+	shared[page] = false;
 }
 
 /*** Memory read port A ***/
@@ -54,7 +102,7 @@ void ram::read_a() {
 	address = (unsigned int)address_a.read();
 
 	if ( address < RAM_SIZE )
-		data_read_a.write(ram_data[address]);
+		data_read_a.write(read_word(address));
 }
 
 
@@ -69,35 +117,35 @@ void ram::write_a() {
 
 
 	if ( wbe != 0 && address < RAM_SIZE) {
-		data = ram_data[address];
+		data = read_word(address);
 
 		switch(wbe) {
 			case 0xF:	// Write word
-				ram_data[address] = data_write_a.read();
+				write_word(address, data_write_a.read());
 			break;
 
 			case 0xC:	// Write MSW
-				ram_data[address] = (data & ~half_word[1]) | (data_write_a.read() & half_word[1]);
+				write_word(address, (data & ~half_word[1]) | (data_write_a.read() & half_word[1]));
 			break;
 
 			case 3:		// Write LSW
-				ram_data[address] = (data & ~half_word[0]) | (data_write_a.read() & half_word[0]);
+				write_word(address, (data & ~half_word[0]) | (data_write_a.read() & half_word[0]));
 			break;
 
 			case 8:		// Write byte 3
-				ram_data[address] = (data & ~byte[3]) | (data_write_a.read() & byte[3]);
+				write_word(address, (data & ~byte[3]) | (data_write_a.read() & byte[3]));
 			break;
 
 			case 4:		// Write byte 2
-				ram_data[address] = (data & ~byte[2]) | (data_write_a.read() & byte[2]);
+				write_word(address, (data & ~byte[2]) | (data_write_a.read() & byte[2]));
 			break;
 
 			case 2:		// Write byte 1
-				ram_data[address] = (data & ~byte[1]) | (data_write_a.read() & byte[1]);
+				write_word(address, (data & ~byte[1]) | (data_write_a.read() & byte[1]));
 			break;
 
 			case 1:		// Write byte 0
-				ram_data[address] = (data & ~byte[0]) | (data_write_a.read() & byte[0]);
+				write_word(address, (data & ~byte[0]) | (data_write_a.read() & byte[0]));
 			break;
 		}
 	}
@@ -112,7 +160,7 @@ void ram::read_b() {
 	address = (unsigned int)address_b.read();
 
 	if ( address < RAM_SIZE )
-		data_read_b.write(ram_data[address]);
+		data_read_b.write(read_word(address));
 }
 
 
@@ -127,37 +175,48 @@ void ram::write_b() {
 
 
 	if ( wbe != 0 && address < RAM_SIZE) {
-		data = ram_data[address];
+		data = read_word(address);
 
 		switch(wbe) {
 			case 0xF:	// Write word
-				ram_data[address] = data_write_b.read();
+				write_word(address, data_write_b.read());
 			break;
 
 			case 0xC:	// Write MSW
-				ram_data[address] = (data & ~half_word[1]) | (data_write_b.read() & half_word[1]);
+				write_word(address, (data & ~half_word[1]) | (data_write_b.read() & half_word[1]));
 			break;
 
 			case 3:		// Write LSW
-				ram_data[address] = (data & ~half_word[0]) | (data_write_b.read() & half_word[0]);
+				write_word(address, (data & ~half_word[0]) | (data_write_b.read() & half_word[0]));
 			break;
 
 			case 8:		// Write byte 3
-				ram_data[address] = (data & ~byte[3]) | (data_write_b.read() & byte[3]);
+				write_word(address, (data & ~byte[3]) | (data_write_b.read() & byte[3]));
 			break;
 
 			case 4:		// Write byte 2
-				ram_data[address] = (data & ~byte[2]) | (data_write_b.read() & byte[2]);
+				write_word(address, (data & ~byte[2]) | (data_write_b.read() & byte[2]));
 			break;
 
 			case 2:		// Write byte 1
-				ram_data[address] = (data & ~byte[1]) | (data_write_b.read() & byte[1]);
+				write_word(address, (data & ~byte[1]) | (data_write_b.read() & byte[1]));
 			break;
 
 			case 1:		// Write byte 0
-				ram_data[address] = (data & ~byte[0]) | (data_write_b.read() & byte[0]);
+				write_word(address, (data & ~byte[0]) | (data_write_b.read() & byte[0]));
 			break;
 		}
 	}
 }
 
+void ram::checkpoint(Checkpoint &ckp){
+
+	// Restored words that match the image keep their pages shared
+	for (unsigned int i = 0; i < RAM_SIZE; i++){
+		uint32_t word = read_word(i);
+		ckp.io(word);
+		if (!ckp.saving())
+			write_word(i, word);
+	}
+}
+
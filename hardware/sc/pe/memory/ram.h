@@ -1,6 +1,10 @@
 /*** RAM memory initialized with kernel object code ***/
 
+#ifndef _ram_h
+#define _ram_h
+
 #include <systemc.h>
+#include <stdint.h>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -9,6 +13,12 @@ using namespace std;
 
 #define RAM_SIZE	MEMORY_SIZE_BYTES/4
 
+// The memory is split in pages. Pages start pointing to the shared image of the ram file
+// and are copied on the first write that changes them
+#define RAM_PAGE_SHIFT	10
+#define RAM_PAGE_WORDS	(1 << RAM_PAGE_SHIFT)
+#define RAM_PAGES		((RAM_SIZE + RAM_PAGE_WORDS - 1) / RAM_PAGE_WORDS)
+
 SC_MODULE(ram) {
 
 	sc_in< bool >			clk;
@@ -24,7 +34,8 @@ SC_MODULE(ram) {
 	sc_in < sc_uint<32> >	data_write_b;
 	sc_out < sc_uint<32> >	data_read_b;
 
-	unsigned long ram_data[RAM_SIZE];
+	uint32_t *pages[RAM_PAGES];
+	bool shared[RAM_PAGES];
 	unsigned long byte[4];
 	unsigned long half_word[2];
 
@@ -36,6 +47,33 @@ SC_MODULE(ram) {
 	void write_b();
 
 	void load_ram();
+	void copy_page(unsigned int page);
+
+	// Pages this PE copied from the shared image
+	unsigned int private_pages(){
+		unsigned int count = 0;
+		for (unsigned int p = 0; p < RAM_PAGES; p++)
+			if (!shared[p])
+				count++;
+		return count;
+	}
+
+	/*** Word access, also used by the CPU direct memory interface ***/
+	uint32_t read_word(unsigned int index){
+		return pages[index >> RAM_PAGE_SHIFT][index & (RAM_PAGE_WORDS - 1)];
+	}
+
+	void write_word(unsigned int index, uint32_t value){
+		unsigned int page = index >> RAM_PAGE_SHIFT;
+		if (shared[page]){
+			if (pages[page][index & (RAM_PAGE_WORDS - 1)] == value)
+				return;
+			copy_page(page);
+		}
+		pages[page][index & (RAM_PAGE_WORDS - 1)] = value;
+	}
+
+	void checkpoint(Checkpoint &ckp);
 
 	SC_HAS_PROCESS(ram);
 	ram(sc_module_name name_, unsigned int address_ = 0) : sc_module(name_), router_address(address_) {
@@ -67,8 +105,16 @@ SC_MODULE(ram) {
 		// Initializes RAM memory with kernel object code.
 	}
 
+	~ram(){
+		for (unsigned int p = 0; p < RAM_PAGES; p++)
+			if (!shared[p])
+				delete[] pages[p];
+	}
+
 	private:
 		unsigned int router_address;
 
 
 };
+
+#endif
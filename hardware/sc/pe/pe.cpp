@@ -14,6 +14,8 @@
 
 #include "pe.h"
 
+bool pe::sim_marker = false;
+
 void pe::repo_to_mem_access(){
 
 	if (reset.read() == 1){
@@ -139,8 +141,6 @@ void pe::reset_n_attr(){
 
 void pe::sequential_attr(){
 
-	FILE *fp;
-
 	if (reset.read() == 1) {
 		cpu_mem_address_reg.write(0);
 		cpu_mem_data_write_reg.write(0);
@@ -150,6 +150,34 @@ void pe::sequential_attr(){
 		tick_counter.write(0);
 		pending_service.write(0);
 		slack_update_timer.write(0);
+	} else if (idle_cycles) {
+
+		//************** catch up with the cycles skipped while idle *******************
+		// The CPU was held and nothing was written to the registers, so only the timers moved
+		sc_uint<32> cycles = idle_cycles + 1;
+
+		if (time_slice.read() > 1) {
+			time_slice.write((time_slice.read() > cycles) ? time_slice.read() - cycles : 1);
+		}
+
+		if (slack_update_timer.read() < SLACK_MONITOR_WINDOW){
+			if (slack_update_timer.read() + cycles < SLACK_MONITOR_WINDOW)
+				slack_update_timer.write(slack_update_timer.read() + cycles);
+			else
+				slack_update_timer.write(SLACK_MONITOR_WINDOW);
+		}
+
+		if (req_app.read()[31] == 0) {
+			ack_app.write(0);
+		}
+
+		router->fluxo_0 += idle_cycles;
+
+		tick_counter.write(tick_counter.read() + cycles);
+
+		idle_cycles = 0;
+		//*********************************************************************
+
 	} else {
 
 		if(cpu_mem_pause.read() == 0) {
@@ -189,18 +217,18 @@ void pe::sequential_attr(){
 
 		//************** simluation-time debug implementation *******************
 		if (cpu_mem_address_reg.read() == DEBUG && write_enable.read() == 1){
-			sprintf(aux, "log/log%dx%d.txt", (unsigned int) router_address.range(15,8), (unsigned int) router_address.range(7,0));
-			fp = fopen (aux, "a");
-
 			uint32_t word = cpu_mem_data_write_reg.read();
 			char str[5] = {};
 		#ifdef MIPS_SIM
 			word = __builtin_bswap32(word);
 		#endif
 			memcpy(str, &word, 4);
-			fprintf(fp, "%s", str);
+			log_puts->write(str);
+		}
 
-			fclose (fp);
+		//************** quantum override end marker *******************
+		if (cpu_mem_address_reg.read() == SIM_MARKER && write_enable.read() == 1){
+			sim_marker = true;
 		}
 
 		//************ NEW DEBBUG AND REPORT logs - they are used by HeMPS Debbuger Tool********
@@ -208,41 +236,26 @@ void pe::sequential_attr(){
 
 			//************** Scheduling report implementation *******************
 			if (cpu_mem_address_reg.read() == SCHEDULING_REPORT) {
-				sprintf(aux, "debug/scheduling_report.txt");
-				fp = fopen (aux, "a");
 				sprintf(aux, "%d\t%d\t%d\n", (unsigned int)router_address, (unsigned int)cpu_mem_data_write_reg.read(), (unsigned int)tick_counter.read());
-				fprintf(fp,"%s",aux);
-				fclose (fp);
+				log_scheduling->write(aux);
 			}
 			//**********************************************************************
 
 			//************** PIPE and request debug implementation *******************
 			if (cpu_mem_address_reg.read() == ADD_PIPE_DEBUG ) {
-				sprintf(aux, "debug/pipe/%d.txt", (unsigned int)router_address);
-				fp = fopen (aux, "a");
 				sprintf(aux, "add\t%d\t%d\t%d\n", (unsigned int)(cpu_mem_data_write_reg.read() >> 16), (unsigned int)(cpu_mem_data_write_reg.read() & 0xFFFF), (unsigned int)tick_counter.read());
-				fprintf(fp,"%s",aux);
-				fclose (fp);
+				log_pipe->write(aux);
 
 			} else if (cpu_mem_address_reg.read() == REM_PIPE_DEBUG ) {
-				sprintf(aux, "debug/pipe/%d.txt", (unsigned int)router_address);
-				fp = fopen (aux, "a");
 				sprintf(aux, "rem\t%d\t%d\t%d\n", (unsigned int)(cpu_mem_data_write_reg.read() >> 16), (unsigned int)(cpu_mem_data_write_reg.read() & 0xFFFF), (unsigned int)tick_counter.read());
-				fprintf(fp,"%s",aux);
-				fclose (fp);
+				log_pipe->write(aux);
 			} else if (cpu_mem_address_reg.read() == ADD_REQUEST_DEBUG ) {
-				sprintf(aux, "debug/request/%d.txt", (unsigned int)router_address);
-				fp = fopen (aux, "a");
 				sprintf(aux, "add\t%d\t%d\t%d\n", (unsigned int)(cpu_mem_data_write_reg.read() >> 16), (unsigned int)(cpu_mem_data_write_reg.read() & 0xFFFF), (unsigned int)tick_counter.read());
-				fprintf(fp,"%s",aux);
-				fclose (fp);
+				log_request->write(aux);
 
 			} else if (cpu_mem_address_reg.read() == REM_REQUEST_DEBUG ) {
-				sprintf(aux, "debug/request/%d.txt", (unsigned int)router_address);
-				fp = fopen (aux, "a");
 				sprintf(aux, "rem\t%d\t%d\t%d\n", (unsigned int)(cpu_mem_data_write_reg.read() >> 16), (unsigned int)(cpu_mem_data_write_reg.read() & 0xFFFF), (unsigned int)tick_counter.read());
-				fprintf(fp,"%s",aux);
-				fclose (fp);
+				log_request->write(aux);
 			}
 		}
 		//**********************************************************************
@@ -290,7 +303,10 @@ void pe::log_process(){
 
 	} else {
 
-		if(tick_counter.read() == 100000*log_interaction) {
+		if(tick_counter.read() >= 100000*log_interaction) {
+		#ifdef RISCV_SIM
+			cpu->update_stats();
+		#endif
 			
 
 			fp = fopen ("log_tasks.txt", "a+");
@@ -389,6 +405,14 @@ void pe::log_process(){
 
 void pe::clock_stop(){
 
+	bool woken = false;
+
+	if (sleeping) {	// Woken by wake_monitor or by the time_slice/slack deadline
+		idle_cycles = (unsigned long int)((sc_time_stamp() - sleep_time) / sc_time(CLOCK_PERIOD_NS, SC_NS));
+		sleeping = false;
+		woken = true;
+	}
+
 	if (reset.read() == 1) {
 		tick_counter_local.write(0);
 		clock_aux = true;
@@ -406,7 +430,150 @@ void pe::clock_stop(){
 		tick_counter_local.write((tick_counter_local.read() + 1) );
 	}
 
-	clock_hold.write(clock and clock_aux);
+#if IDLE_PE_SKIP
+	clock_pe.write(clock);
+
+	//************** idle PE skipping *******************
+	// A held PE without traffic only counts time. It leaves the clock until a flit or an
+	// application request arrives, or until the cycle before time_slice or the slack
+	// monitor would release the CPU. sequential_attr catches up the skipped cycles.
+	if (!woken && clock.posedge() && clock_aux == false && idle_cycles == 0 && idle() && !Checkpoint::park()){
+		unsigned long int deadline = 0;
+
+		if (time_slice.read() > 1)
+			deadline = time_slice.read() - 2;
+
+		if (slack_update_timer.read() < SLACK_MONITOR_WINDOW){
+			unsigned long int slack_deadline = SLACK_MONITOR_WINDOW - slack_update_timer.read() - 1;
+			if (time_slice.read() <= 1 || slack_deadline < deadline)
+				deadline = slack_deadline;
+		} else if (time_slice.read() <= 1) {
+			deadline = ~0UL;
+		}
+
+		if (deadline > 0){
+			sleeping = true;
+			sleep_time = sc_time_stamp();
+			if (deadline == ~0UL)
+				next_trigger(wake_event);
+			else	// Wakes at the falling edge, so the catch-up runs on the rising one
+				next_trigger(sc_time(deadline * CLOCK_PERIOD_NS - CLOCK_PERIOD_NS/2.0, SC_NS), wake_event);
+		}
+	}
+	//*********************************************************************
+#else
+	clock_hold.write(clock and (clock_aux or Checkpoint::park()));	// A held CPU runs until it parks
+#endif
 
 }
 
+void pe::clock_gate(){
+	clock_hold.write(clock_pe and (clock_aux or Checkpoint::park()));	// A held CPU runs until it parks
+}
+
+void pe::wake_monitor(){
+	if (sleeping)
+		wake_event.notify();
+}
+
+bool pe::idle(){
+	return reset.read() == 0 && repo_FSM.read() == WAIT && cpu_repo_acess.read() == 0 && write_enable.read() == 0 &&
+		ni_intr.read() == 0 && dm_ni->idle() && router->idle();
+}
+
+// Lets the CPU run OVERRIDE_QUANTUM cycles ahead of the clock, in basic blocks on RiscV,
+// or back with the timing configured for the platform
+void pe::override_quantum(bool enable){
+	cpu->set_quantum(enable ? OVERRIDE_QUANTUM : QUANTUM_CYCLES);
+#ifdef RISCV_SIM
+	cpu->set_block_exec(enable || BLOCK_EXEC);
+#endif
+}
+
+// Saves or loads the PE state. The clock derived signals are not saved
+void pe::checkpoint(Checkpoint &ckp){
+
+	ckp.io(cpu_mem_address_reg);
+	ckp.io(cpu_mem_data_write_reg);
+	ckp.io(cpu_mem_write_byte_enable_reg);
+	ckp.io(irq_mask_reg);
+	ckp.io(irq_status);
+	ckp.io(irq);
+	ckp.io(time_slice);
+	ckp.io(write_enable);
+	ckp.io(tick_counter_local);
+	ckp.io(tick_counter);
+	ckp.io(current_page);
+
+	ckp.io(cpu_mem_address);
+	ckp.io(cpu_mem_data_write);
+	ckp.io(cpu_mem_data_read);
+	ckp.io(cpu_mem_write_byte_enable);
+	ckp.io(cpu_mem_pause);
+	ckp.io(cpu_enable_ram);
+	ckp.io(cpu_set_size);
+	ckp.io(cpu_set_address);
+	ckp.io(cpu_set_size_2);
+	ckp.io(cpu_set_address_2);
+	ckp.io(cpu_set_op);
+	ckp.io(cpu_start);
+	ckp.io(cpu_ack);
+
+	ckp.io(data_read_ram);
+	ckp.io(mem_data_read);
+	ckp.io(ni_intr);
+
+	ckp.io(clock_tx_ni);
+	ckp.io(tx_ni);
+	ckp.io(data_out_ni);
+	ckp.io(credit_i_ni);
+	ckp.io(clock_rx_ni);
+	ckp.io(rx_ni);
+	ckp.io(data_in_ni);
+	ckp.io(credit_o_ni);
+	ckp.io(vc_in_ni);
+	ckp.io(vc_out_ni);
+
+	ckp.io(dmni_mem_address);
+	ckp.io(dmni_mem_addr_ddr);
+	ckp.io(dmni_mem_ddr_read_req);
+	ckp.io(mem_ddr_access);
+	ckp.io(dmni_mem_write_byte_enable);
+	ckp.io(dmni_mem_data_write);
+	ckp.io(dmni_mem_data_read);
+	ckp.io(dmni_data_read);
+	ckp.io(dmni_enable_internal_ram);
+	ckp.io(dmni_send_active_sig);
+	ckp.io(dmni_receive_active_sig);
+	ckp.io(address_mux);
+	ckp.io(cpu_mem_address_reg2);
+	ckp.io(addr_a);
+	ckp.io(addr_b);
+	ckp.io(cpu_repo_acess);
+	ckp.io(pending_service);
+	ckp.io(reset_n);
+	ckp.io(end_sim_reg);
+	ckp.io(slack_update_timer);
+	ckp.io(repo_FSM);
+
+	ckp.io(clock_aux);
+	ckp.io(idle_cycles);
+
+	ckp.io(log_interaction);
+	ckp.io(instant_instructions);
+	ckp.io(logical_instant_instructions);
+	ckp.io(jump_instant_instructions);
+	ckp.io(branch_instant_instructions);
+	ckp.io(move_instant_instructions);
+	ckp.io(other_instant_instructions);
+	ckp.io(arith_instant_instructions);
+	ckp.io(load_instant_instructions);
+	ckp.io(shift_instant_instructions);
+	ckp.io(nop_instant_instructions);
+	ckp.io(mult_div_instant_instructions);
+
+	cpu->checkpoint(ckp);
+	mem->checkpoint(ckp);
+	dm_ni->checkpoint(ckp);
+	router->checkpoint(ckp);
+}
@@ -4,6 +4,7 @@
 
 #include <systemc.h>
 #include "../standards.h"
+#include "../logger.h"
 #ifdef MIPS_SIM
 	#include "processor/plasma/mlite_cpu.h"
 #elif defined(RISCV_SIM)
@@ -13,6 +14,15 @@
 #include "router/router_cc.h"
 #include "memory/ram.h"
 
+// Clock of the PE modules that can be skipped while the CPU is held
+#if IDLE_PE_SKIP
+	#define PE_CLOCK		clock_pe
+	#define PE_CLOCK_POS	clock_pe.posedge_event()
+#else
+	#define PE_CLOCK		clock
+	#define PE_CLOCK_POS	clock.pos()
+#endif
+
 SC_MODULE(pe) {
 	
 	sc_in< bool >		clock;
@@ -20,16 +30,25 @@ SC_MODULE(pe) {
 	sc_signal < bool > 	clock_hold;
 	bool 				clock_aux;
 
+	// Idle PE skipping
+	sc_signal < bool >	clock_pe;
+	sc_event			wake_event;
+	bool				sleeping;
+	sc_time				sleep_time;
+	unsigned long int	idle_cycles;
+
 	// NoC Interface
 	sc_out<bool >		clock_tx[NPORT-1];
 	sc_out<bool >		tx[NPORT-1];
 	sc_out<regflit >	data_out[NPORT-1];
-	sc_in<bool >		credit_i[NPORT-1];
+	sc_out<regvc >		vc_out[NPORT-1];
+	sc_in<regcredit >	credit_i[NPORT-1];
 	
 	sc_in<bool >		clock_rx[NPORT-1];
 	sc_in<bool > 		rx[NPORT-1];
 	sc_in<regflit >		data_in[NPORT-1];
-	sc_out<bool >		credit_o[NPORT-1];
+	sc_in<regvc >		vc_in[NPORT-1];
+	sc_out<regcredit >	credit_o[NPORT-1];
 	
 	//Dynamic Insertion of Applications
 	sc_out<bool >				ack_app;
@@ -75,11 +94,13 @@ SC_MODULE(pe) {
 	sc_signal< bool > 			clock_tx_ni;
 	sc_signal< bool > 			tx_ni;
 	sc_signal< regflit > 		data_out_ni;
-	sc_signal< bool > 			credit_i_ni;
+	sc_signal< regcredit > 		credit_i_ni;
 	sc_signal< bool > 			clock_rx_ni;
 	sc_signal< bool > 			rx_ni;
 	sc_signal< regflit > 		data_in_ni;
-	sc_signal< bool > 			credit_o_ni;
+	sc_signal< regcredit > 		credit_o_ni;
+	sc_signal< regvc > 			vc_in_ni;		// The DMNI link has a single channel
+	sc_signal< regvc > 			vc_out_ni;
 	//dmni
 	sc_signal < sc_uint <32 > > dmni_mem_address;
 	sc_signal < sc_uint <32 > > dmni_mem_addr_ddr;
@@ -142,6 +163,9 @@ SC_MODULE(pe) {
 	char aux[255];
 	FILE *fp;
 
+	// Kernel puts() output and HeMPS Debugger reports
+	Logger::Log *log_puts, *log_scheduling, *log_pipe, *log_request;
+
 	//logfilegen *log;
 	
 	void sequential_attr();
@@ -152,12 +176,31 @@ SC_MODULE(pe) {
 	void clock_stop();
 	void end_of_simulation();
 	void repo_to_mem_access();
+	void clock_gate();
+	void wake_monitor();
+	bool idle();
+	void checkpoint(Checkpoint &ckp);
+	void override_quantum(bool enable);
+
+	// A CPU wrote to SIM_MARKER
+	static bool sim_marker;
 	
 	SC_HAS_PROCESS(pe);
-	pe(sc_module_name name_, regaddress address_ = 0x00) : sc_module(name_), router_address(address_) {
+	pe(sc_module_name name_, regaddress address_ = 0x00, const NocConfig &noc = NocConfig()) : sc_module(name_), router_address(address_) {
 
 		end_sim_reg.write(0x00000001);
 
+		sprintf(aux, "log/log%dx%d.txt", (unsigned int) router_address.range(15,8), (unsigned int) router_address.range(7,0));
+		log_puts = Logger::open(aux);
+		log_scheduling = Logger::open("debug/scheduling_report.txt");
+		sprintf(aux, "debug/pipe/%d.txt", (unsigned int)router_address);
+		log_pipe = Logger::open(aux);
+		sprintf(aux, "debug/request/%d.txt", (unsigned int)router_address);
+		log_request = Logger::open(aux);
+
+		sleeping = false;
+		idle_cycles = 0;
+
 		shift_mem_page = (unsigned char) (log10(PAGE_SIZE_BYTES)/log10(2));
 	#ifdef MIPS_SIM
 		cpu = new mlite_cpu("cpu", router_address);
@@ -175,7 +218,7 @@ SC_MODULE(pe) {
 		cpu->current_page(current_page);
 		
 		mem = new ram("ram", (unsigned int) router_address);
-		mem->clk(clock);
+		mem->clk(PE_CLOCK);
 		mem->enable_a(cpu_enable_ram);
 		mem->wbe_a(cpu_mem_write_byte_enable);
 		mem->address_a(addr_a);
@@ -187,8 +230,17 @@ SC_MODULE(pe) {
 		mem->data_write_b(dmni_mem_data_write);
 		mem->data_read_b(mem_data_read);
 
+	#if DMI_ENABLE
+		cpu->set_dmi(mem, RAM_SIZE);
+	#endif
+		cpu->set_quantum(QUANTUM_CYCLES);
+	#ifdef RISCV_SIM
+		cpu->set_block_exec(BLOCK_EXEC);
+		cpu->set_tlb(TLB_ENTRIES, TLB_WAYS);
+	#endif
+
 		dm_ni = new dmni("dmni", router_address);
-		dm_ni->clock(clock);
+		dm_ni->clock(PE_CLOCK);
 		dm_ni->reset(reset);
 
 		dm_ni->set_address(cpu_set_address);
@@ -216,9 +268,10 @@ SC_MODULE(pe) {
 		dm_ni->rx(rx_ni);
 		dm_ni->data_in(data_in_ni);
 		dm_ni->credit_o(credit_o_ni);
+		dm_ni->tick_counter(tick_counter);
 
-		router = new router_cc("router",router_address);
-		router->clock(clock);
+		router = new router_cc("router",router_address, noc);
+		router->clock(PE_CLOCK);
 		router->reset_n(reset_n);
 		router->clock_tx[EAST] (clock_tx[EAST] );
 		router->clock_tx[WEST] (clock_tx[WEST] );
@@ -240,6 +293,11 @@ SC_MODULE(pe) {
 		router->data_out[NORTH](data_out[NORTH]);
 		router->data_out[SOUTH](data_out[SOUTH]);
 		router->data_out[LOCAL](data_in_ni);
+		router->vc_out[EAST](vc_out[EAST]);
+		router->vc_out[WEST](vc_out[WEST]);
+		router->vc_out[NORTH](vc_out[NORTH]);
+		router->vc_out[SOUTH](vc_out[SOUTH]);
+		router->vc_out[LOCAL](vc_out_ni);
 		router->rx[EAST](rx[EAST]);
 		router->rx[WEST](rx[WEST]);
 		router->rx[NORTH](rx[NORTH]);
@@ -255,6 +313,11 @@ SC_MODULE(pe) {
 		router->data_in[NORTH](data_in[NORTH]);
 		router->data_in[SOUTH](data_in[SOUTH]);
 		router->data_in[LOCAL](data_out_ni);
+		router->vc_in[EAST](vc_in[EAST]);
+		router->vc_in[WEST](vc_in[WEST]);
+		router->vc_in[NORTH](vc_in[NORTH]);
+		router->vc_in[SOUTH](vc_in[SOUTH]);
+		router->vc_in[LOCAL](vc_in_ni);
 		router->clock_rx[EAST] (clock_rx[EAST]);
 		router->clock_rx[WEST] (clock_rx[WEST]);
 		router->clock_rx[NORTH](clock_rx[NORTH]);
@@ -266,10 +329,10 @@ SC_MODULE(pe) {
 		sensitive << reset;
 		
 		SC_METHOD(sequential_attr);
-		sensitive << clock.pos() << reset.pos();
+		sensitive << PE_CLOCK_POS << reset.pos();
 		
 		SC_METHOD(log_process);
-		sensitive << clock.pos() << reset.pos();
+		sensitive << PE_CLOCK_POS << reset.pos();
 		
 		SC_METHOD(comb_assignments);
 		sensitive << cpu_mem_address << dmni_mem_address << cpu_mem_address_reg << write_enable;
@@ -294,9 +357,19 @@ SC_MODULE(pe) {
 		sensitive << clock << reset.pos();	
 		
 		SC_METHOD(repo_to_mem_access);
-		sensitive << clock.pos();
+		sensitive << PE_CLOCK_POS;
 		sensitive << reset;
 
+	#if IDLE_PE_SKIP
+		SC_METHOD(clock_gate);
+		sensitive << clock_pe;
+
+		SC_METHOD(wake_monitor);
+		sensitive << rx[EAST] << rx[WEST] << rx[NORTH] << rx[SOUTH];
+		sensitive << req_app << reset;
+		dont_initialize();
+	#endif
+
 	}
 	
 	public:
@@ -27,6 +27,180 @@
 SC_MODULE_EXPORT(mlite_cpu);
 #endif
 
+/*** DMI and temporal decoupling ***/
+void mlite_cpu::set_dmi(ram *ram_, unsigned int words_) {
+	dmi_ram = ram_;
+	dmi_words = words_;
+}
+
+void mlite_cpu::set_quantum(unsigned int cycles_) {
+	quantum = cycles_;
+}
+
+// Returns the RAM word addressed through DMI, applying the page relocation of the PE, or -1 if out of the RAM
+int mlite_cpu::dmi_index(unsigned int address) {
+
+	unsigned int index;
+
+	if ( dmi_ram == NULL || ((address >> 28) & 0x7) != 0 )	// MMIO or repository
+		return -1;
+
+	if ( dmi_page && ((0xFFFFFFFF << shift) & address) ) {
+		address &= (0xF0000000 | (0xFFFFFFFF >> (32-shift)));
+		address |= dmi_page * PAGE_SIZE_BYTES;
+	}
+
+	index = address >> 2;
+
+	return (index < dmi_words) ? index : -1;
+}
+
+// Drives the bus address. Accesses out of the RAM sync with the clock and keep the bus signals for the read latency
+void mlite_cpu::bus_address(unsigned int address) {
+
+	bus_index = dmi_index(address);
+
+	if ( bus_index < 0 ) {
+		sync();
+		bus_sync = 3;
+	}
+
+	if ( bus_sync )
+		mem_address.write(address);
+}
+
+void mlite_cpu::bus_data(unsigned int data) {
+
+	bus_data_w = data;
+
+	if ( bus_sync )
+		mem_data_w.write(data);
+}
+
+void mlite_cpu::bus_byte_we(sc_uint<4> we) {
+
+	unsigned int mask;
+
+	if ( we != 0 && !bus_sync && bus_index >= 0 ) {
+		mask = 0;
+		for (int i = 0; i < 4; i++)
+			if ( we[i] )
+				mask |= 0xFF << (i*8);
+
+		dmi_ram->write_word(bus_index, (dmi_ram->read_word(bus_index) & ~mask) | (bus_data_w & mask));
+		return;
+	}
+
+	if ( we != bus_we ) {
+		mem_byte_we.write(we);
+		bus_we = we;
+	}
+}
+
+// The read data bus returns the word addressed two cycles before
+sc_uint<32> mlite_cpu::bus_read() {
+
+	if ( bus_index_2 >= 0 )
+		return dmi_ram->read_word(bus_index_2);
+
+	return mem_data_r.read();
+}
+
+void mlite_cpu::consume(unsigned int cycles) {
+
+	bus_index_2 = (cycles > 1) ? bus_index : bus_index_1;
+	bus_index_1 = bus_index;
+
+	if ( bus_sync || !quantum ) {
+		sync();
+		wait(cycles);
+
+		bus_sync = (bus_sync > cycles) ? bus_sync - cycles : 0;
+		if ( mem_pause.read() && !bus_sync )	// Keeps in sync while the repository is accessed
+			bus_sync = 1;
+		return;
+	}
+
+	local_cycles += cycles;
+	if ( local_cycles >= quantum )
+		sync();
+}
+
+void mlite_cpu::sync() {
+
+	if ( local_cycles ) {
+		wait(local_cycles);
+		local_cycles = 0;
+	}
+}
+
+/*** Checkpoint ***/
+// Saves or loads the CPU state. The CPU must be parked
+void mlite_cpu::checkpoint(Checkpoint &ckp) {
+
+	ckp.io(state->r);
+	ckp.io(state->pc);
+	ckp.io(state->epc);
+	ckp.io(state->global_inst_reg);
+	ckp.io(state->hi);
+	ckp.io(state->lo);
+
+	ckp.io(opcode);
+	ckp.io(prefetched_opcode);
+	ckp.io(pc_last);
+	ckp.io(word_addr);
+	ckp.io(page);
+	ckp.io(intr_enable);
+	ckp.io(prefetch);
+	ckp.io(jump_or_branch);
+	ckp.io(no_execute_branch_delay_slot);
+
+	ckp.io(dmi_page);
+	ckp.io(bus_data_w);
+	ckp.io(bus_sync);
+	ckp.io(bus_we);
+	ckp.io(bus_index);
+	ckp.io(bus_index_1);
+	ckp.io(bus_index_2);
+
+	ckp.io(pc_count);
+	ckp.io(global_inst);
+	ckp.io(logical_inst);
+	ckp.io(branch_inst);
+	ckp.io(jump_inst);
+	ckp.io(move_inst);
+	ckp.io(other_inst);
+	ckp.io(arith_inst);
+	ckp.io(load_inst);
+	ckp.io(shift_inst);
+	ckp.io(nop_inst);
+	ckp.io(mult_div_inst);
+
+	ckp.io(global_inst_kernel);
+	ckp.io(logical_inst_kernel);
+	ckp.io(branch_inst_kernel);
+	ckp.io(jump_inst_kernel);
+	ckp.io(move_inst_kernel);
+	ckp.io(other_inst_kernel);
+	ckp.io(arith_inst_kernel);
+	ckp.io(load_inst_kernel);
+	ckp.io(shift_inst_kernel);
+	ckp.io(nop_inst_kernel);
+	ckp.io(mult_div_inst_kernel);
+
+	ckp.io(global_inst_tasks);
+	ckp.io(logical_inst_tasks);
+	ckp.io(branch_inst_tasks);
+	ckp.io(jump_inst_tasks);
+	ckp.io(move_inst_tasks);
+	ckp.io(other_inst_tasks);
+	ckp.io(arith_inst_tasks);
+	ckp.io(load_inst_tasks);
+	ckp.io(shift_inst_tasks);
+	ckp.io(nop_inst_tasks);
+	ckp.io(mult_div_inst_tasks);
+}
+
 /*** Process thread ***/
 void mlite_cpu::mlite() {
 
@@ -72,7 +246,16 @@ void mlite_cpu::mlite() {
   
 	for(;;) {
 
-		current_page.write(page>>shift);
+		if ( Checkpoint::park() ) {	// Stops between two instructions while a checkpoint is taken
+			sync();
+			Checkpoint::parked()++;
+			while ( Checkpoint::park() )
+				wait();
+			Checkpoint::parked()--;
+		}
+
+		dmi_page = page>>shift;
+		current_page.write(dmi_page);
 
 		if ( !mem_pause )
 			pc_last = state->pc;	// Stores the last pc address
@@ -85,23 +268,26 @@ void mlite_cpu::mlite() {
 			no_execute_branch_delay_slot = false;
 			state->pc = 0;
 			global_inst = 0;
-			mem_byte_we.write(0x0);
-			mem_address.write(state->pc);
+			bus_byte_we(0x0);
+			bus_address(state->pc);
 			word_addr = -4;					// 0xFFFFFFFC
-			wait(17);
+			consume(17);
 		}
 		else {
 			r = (int*)state->r;			// Signed mask.
 			u = (unsigned int*)state->r;	// Unsigned mask.
 
 
+			if ( local_cycles && intr_enable && intr_in.read() )	// Takes the interrupt in sync with the clock
+				sync();
+
 			if ( intr_in.read() && intr_enable && !jump_or_branch ) {	// Does not interrupt a Branch Delay Slot.
 				state->epc = state->pc - 4;
 				state->pc = 0x3C;
 				page = 0;
-				mem_address.write(state->pc);
-				opcode = mem_data_r.read();
-				wait(1);
+				bus_address(state->pc);
+				opcode = bus_read();
+				consume(1);
 				intr_enable = false;
 				no_execute_branch_delay_slot = true;	// Does not execute the Branch Delay Slot instruction relative to the ISR jump.
 				continue;		// Executes the loaded instruction after the ISR.
@@ -114,13 +300,13 @@ void mlite_cpu::mlite() {
 			state->pc |= page;
 
 			// Instruction read.
-			mem_address.write(state->pc);
+			bus_address(state->pc);
 			if ( prefetch ) {
 				opcode = prefetched_opcode;
 				prefetch = false;
 			}
 			else
-				opcode = mem_data_r.read();
+				opcode = bus_read();
 
 			op = (opcode >> 26) & 0x3f;
 			rs = (opcode >> 21) & 0x1f;
@@ -145,7 +331,7 @@ void mlite_cpu::mlite() {
 
 				nop_inst_kernel=(page != 0? nop_inst_kernel : nop_inst_kernel + 1 );
 				nop_inst_tasks=(page != 0? nop_inst_tasks + 1  : nop_inst_tasks );
-				wait(1);
+				consume(1);
 				no_execute_branch_delay_slot = false;
 				continue;
 			}
@@ -159,7 +345,7 @@ void mlite_cpu::mlite() {
 				case 0x00:/*SPECIAL*/
 					switch(func) {
 						case 0x00:/*SLL*/
-							wait(1);
+							consume(1);
 							r[rd]=r[rt]<<re;
 							
 							shift_inst_kernel=(page != 0? shift_inst_kernel : shift_inst_kernel + 1 );
@@ -169,7 +355,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x02:/*SRL*/
-							wait(1);
+							consume(1);
 							r[rd]=u[rt]>>re;
 							
 							shift_inst_kernel=(page != 0? shift_inst_kernel : shift_inst_kernel + 1 );
@@ -178,7 +364,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x03:/*SRA*/
-							wait(1);
+							consume(1);
 							r[rd]=r[rt]>>re;
 							
 							shift_inst_kernel=(page != 0? shift_inst_kernel : shift_inst_kernel + 1 );
@@ -187,7 +373,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x04:/*SLLV*/
-							wait(1);
+							consume(1);
 							r[rd]=r[rt]<<r[rs];
 							
 							shift_inst_kernel=(page != 0? shift_inst_kernel : shift_inst_kernel + 1 );
@@ -196,7 +382,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x06:/*SRLV*/
-							wait(1);
+							consume(1);
 							r[rd]=u[rt]>>r[rs];
 							
 							shift_inst_kernel=(page != 0? shift_inst_kernel : shift_inst_kernel + 1 );
@@ -205,7 +391,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x07:/*SRAV*/
-							wait(1);
+							consume(1);
 							r[rd]=r[rt]>>r[rs];
 							
 							shift_inst_kernel=(page != 0? shift_inst_kernel : shift_inst_kernel + 1 );
@@ -217,8 +403,8 @@ void mlite_cpu::mlite() {
 							jump_or_branch = true;
 							state->pc = r[rs];
 							state->pc |= page;
-							mem_address.write(state->pc);
-							wait(1);
+							bus_address(state->pc);
+							consume(1);
 							
 							jump_inst_kernel=(page != 0? jump_inst_kernel : jump_inst_kernel + 1 );
 							jump_inst_tasks=(page != 0? jump_inst_tasks + 1  : jump_inst_tasks );
@@ -230,8 +416,8 @@ void mlite_cpu::mlite() {
 							r[rd] = state->pc;
 							state->pc = r[rs];
 							state->pc |= page;
-							mem_address.write(state->pc);
-							wait(1);
+							bus_address(state->pc);
+							consume(1);
 							
 							jump_inst_kernel=(page != 0? jump_inst_kernel : jump_inst_kernel + 1 );
 							jump_inst_tasks=(page != 0? jump_inst_tasks + 1  : jump_inst_tasks );
@@ -239,7 +425,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x0a:/*MOVZ*/
-							wait(1);
+							consume(1);
 							if ( !r[rt] )
 								r[rd] = r[rs];
 								
@@ -249,7 +435,7 @@ void mlite_cpu::mlite() {
 						break;  /*IV*/
 
 						case 0x0b:/*MOVN*/
-							wait(1);
+							consume(1);
 							if ( r[rt] )
 								r[rd] = r[rs];
 								
@@ -262,9 +448,10 @@ void mlite_cpu::mlite() {
 							state->epc = state->pc;
 							state->pc = 0x44;							
 							page = 0;
-							current_page.write(page>>shift);
-							mem_address.write(state->pc);
-							wait(1);
+							dmi_page = page>>shift;
+							current_page.write(dmi_page);
+							bus_address(state->pc);
+							consume(1);
 							intr_enable = false;
 										
 							other_inst_kernel=(page != 0? other_inst_kernel : other_inst_kernel + 1 );
@@ -273,7 +460,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x0d:/*BREAK*/
-							wait(1);
+							consume(1);
 							
 							other_inst_kernel=(page != 0? other_inst_kernel : other_inst_kernel + 1 );
 							other_inst_tasks=(page != 0? other_inst_tasks + 1  : other_inst_tasks );
@@ -281,7 +468,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x0f:/*SYNC*/
-							wait(1);
+							consume(1);
 							
 							other_inst_kernel=(page != 0? other_inst_kernel : other_inst_kernel + 1 );
 							other_inst_tasks=(page != 0? other_inst_tasks + 1  : other_inst_tasks );
@@ -289,7 +476,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x10:/*MFHI*/
-							wait(1);
+							consume(1);
 							r[rd] = state->hi;
 							
 							move_inst_kernel=(page != 0? move_inst_kernel : move_inst_kernel + 1 );
@@ -298,7 +485,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x11:/*MTHI*/
-							wait(1);
+							consume(1);
 							state->hi = r[rs];
 							
 							move_inst_kernel=(page != 0? move_inst_kernel : move_inst_kernel + 1 );
@@ -307,7 +494,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x12:/*MFLO*/
-							wait(1);
+							consume(1);
 							r[rd] = state->lo;
 							
 							move_inst_kernel=(page != 0? move_inst_kernel : move_inst_kernel + 1 );
@@ -316,7 +503,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x13:/*MTLO*/
-							wait(1);
+							consume(1);
 							state->lo = r[rs];
 							
 							move_inst_kernel=(page != 0? move_inst_kernel : move_inst_kernel + 1 );
@@ -325,12 +512,12 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x18:/*MULT*/
-							wait(1);
+							consume(1);
 
 							prefetch = true;
-							prefetched_opcode = mem_data_r.read();
-							mem_address.write(state->pc);
-							wait(4);
+							prefetched_opcode = bus_read();
+							bus_address(state->pc);
+							consume(4);
 
 							mult_big_signed(r[rs],r[rt]);
 							//sc_int<64> result;
@@ -345,12 +532,12 @@ void mlite_cpu::mlite() {
 
 						case 0x19:/*MULTU*/
 							//state->lo=r[rs]*r[rt]; state->hi=0; break;
-							wait(1);
+							consume(1);
 
 							prefetch = true;
-							prefetched_opcode = mem_data_r.read();
-							mem_address.write(state->pc);
-							wait(4);
+							prefetched_opcode = bus_read();
+							bus_address(state->pc);
+							consume(4);
 
 							mult_big(r[rs],r[rt]);
 							//sc_uint<64> result;
@@ -364,12 +551,12 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x1a:/*DIV*/
-							wait(1);
+							consume(1);
 
 							prefetch = true;
-							prefetched_opcode = mem_data_r.read();
-							mem_address.write(state->pc);
-							wait(4);
+							prefetched_opcode = bus_read();
+							bus_address(state->pc);
+							consume(4);
 							
 							state->lo = (r[rt]>0) ? r[rs] / r[rt] : 0;
 							state->hi = (r[rt]>0) ? r[rs] % r[rt] : r[rs];
@@ -382,12 +569,12 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x1b:/*DIVU*/
-							wait(1);
+							consume(1);
 
 							prefetch = true;
-							prefetched_opcode = mem_data_r.read();
-							mem_address.write(state->pc);
-							wait(4);
+							prefetched_opcode = bus_read();
+							bus_address(state->pc);
+							consume(4);
 
 							state->lo = u[rs] / u[rt];
 							state->hi = u[rs] % u[rt];
@@ -398,7 +585,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x20:/*ADD*/
-							wait(1);
+							consume(1);
 							r[rd] = r[rs] + r[rt];
 							
 							arith_inst_kernel=(page != 0? arith_inst_kernel : arith_inst_kernel + 1 );
@@ -407,7 +594,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x21:/*ADDU*/
-							wait(1);
+							consume(1);
 							r[rd] = r[rs] + r[rt];
 							
 							arith_inst_kernel=(page != 0? arith_inst_kernel : arith_inst_kernel + 1 );
@@ -416,7 +603,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x22:/*SUB*/
-							wait(1);
+							consume(1);
 							r[rd] = r[rs] - r[rt];
 							
 							arith_inst_kernel=(page != 0? arith_inst_kernel : arith_inst_kernel + 1 );
@@ -425,7 +612,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x23:/*SUBU*/
-							wait(1);
+							consume(1);
 							r[rd] = r[rs] - r[rt];
 							
 							arith_inst_kernel=(page != 0? arith_inst_kernel : arith_inst_kernel + 1 );
@@ -434,7 +621,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x24:/*AND*/
-							wait(1);
+							consume(1);
 							r[rd] = r[rs] & r[rt];
 							
 							logical_inst_kernel=(page != 0? logical_inst_kernel : logical_inst_kernel + 1 );
@@ -443,7 +630,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x25:/*OR*/
-							wait(1);
+							consume(1);
 							r[rd] = r[rs] | r[rt];
 							
 							logical_inst_kernel=(page != 0? logical_inst_kernel : logical_inst_kernel + 1 );
@@ -452,7 +639,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x26:/*XOR*/
-							wait(1);
+							consume(1);
 							r[rd] = r[rs] ^ r[rt];
 							
 							logical_inst_kernel=(page != 0? logical_inst_kernel : logical_inst_kernel + 1 );
@@ -461,7 +648,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x27:/*NOR*/
-							wait(1);
+							consume(1);
 							r[rd] = ~(r[rs] | r[rt]);
 							
 							logical_inst_kernel=(page != 0? logical_inst_kernel : logical_inst_kernel + 1 );
@@ -470,7 +657,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x2a:/*SLT*/
-							wait(1);
+							consume(1);
 							r[rd]= (r[rs] < r[rt]);
 							
 							arith_inst_kernel=(page != 0? arith_inst_kernel : arith_inst_kernel + 1 );
@@ -479,7 +666,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x2b:/*SLTU*/
-							wait(1);
+							consume(1);
 							r[rd] = (u[rs] < u[rt]);
 							
 							arith_inst_kernel=(page != 0? arith_inst_kernel : arith_inst_kernel + 1 );
@@ -488,7 +675,7 @@ void mlite_cpu::mlite() {
 						break;
 
 						case 0x2d:/*DADDU*/
-							wait(1);
+							consume(1);
 							r[rd] = r[rs] + u[rt];
 							
 							arith_inst_kernel=(page != 0? arith_inst_kernel : arith_inst_kernel + 1 );
@@ -498,7 +685,7 @@ void mlite_cpu::mlite() {
 
 						case 0x31:/*TGEU*/ 
 						
-							wait(1); 
+							consume(1); 
 							other_inst_kernel=(page != 0? other_inst_kernel : other_inst_kernel + 1 );
 							other_inst_tasks=(page != 0? other_inst_tasks + 1  : other_inst_tasks );
 
@@ -506,7 +693,7 @@ void mlite_cpu::mlite() {
 						
 						case 0x32:/*TLT*/  
 						
-							wait(1); 
+							consume(1); 
 							other_inst_kernel=(page != 0? other_inst_kernel : other_inst_kernel + 1 );
 							other_inst_tasks=(page != 0? other_inst_tasks + 1  : other_inst_tasks );
 							
@@ -514,21 +701,21 @@ void mlite_cpu::mlite() {
 						
 						case 0x33:/*TLTU*/ 
 						
-							wait(1); 
+							consume(1); 
 							other_inst_kernel=(page != 0? other_inst_kernel : other_inst_kernel + 1 );
 							other_inst_tasks=(page != 0? other_inst_tasks + 1  : other_inst_tasks );
 							
 						break;
 						case 0x34:/*TEQ*/  
 						
-							wait(1); 
+							consume(1); 
 							other_inst_kernel=(page != 0? other_inst_kernel : other_inst_kernel + 1 );
 							other_inst_tasks=(page != 0? other_inst_tasks + 1  : other_inst_tasks );
 
 						break;
 						case 0x36:/*TNE*/ 
 						 
-							wait(1); 
+							consume(1); 
 							other_inst_kernel=(page != 0? other_inst_kernel : other_inst_kernel + 1 );
 							other_inst_tasks=(page != 0? other_inst_tasks + 1  : other_inst_tasks );
 
@@ -546,9 +733,9 @@ void mlite_cpu::mlite() {
 								jump_or_branch = true;
 								r[31] = state->pc;
 								state->pc += imm_shift;
-								mem_address.write(state->pc);
+								bus_address(state->pc);
 							}
-							wait(1);
+							consume(1);
 							
 							branch_inst_kernel=(page != 0? branch_inst_kernel : branch_inst_kernel + 1 );
 							branch_inst_tasks=(page != 0? branch_inst_tasks + 1  : branch_inst_tasks );
@@ -559,9 +746,9 @@ void mlite_cpu::mlite() {
 							if ( r[rs] < 0 ) {
 								jump_or_branch = true;
 								state->pc += imm_shift;
-								mem_address.write(state->pc);
+								bus_address(state->pc);
 							}
-							wait(1);
+							consume(1);
 							
 							branch_inst_kernel=(page != 0? branch_inst_kernel : branch_inst_kernel + 1 );
 							branch_inst_tasks=(page != 0? branch_inst_tasks + 1  : branch_inst_tasks );
@@ -573,9 +760,9 @@ void mlite_cpu::mlite() {
 								jump_or_branch = true;
 								r[31] = state->pc;
 								state->pc += imm_shift;
-								mem_address.write(state->pc);
+								bus_address(state->pc);
 							}
-							wait(1);
+							consume(1);
 							
 							branch_inst_kernel=(page != 0? branch_inst_kernel : branch_inst_kernel + 1 );
 							branch_inst_tasks=(page != 0? branch_inst_tasks + 1  : branch_inst_tasks );
@@ -586,9 +773,9 @@ void mlite_cpu::mlite() {
 							if ( r[rs] >= 0 ) {
 								jump_or_branch = true;
 								state->pc += imm_shift;
-								mem_address.write(state->pc);
+								bus_address(state->pc);
 							}
-							wait(1);
+							consume(1);
 							
 							branch_inst_kernel=(page != 0? branch_inst_kernel : branch_inst_kernel + 1 );
 							branch_inst_tasks=(page != 0? branch_inst_tasks + 1  : branch_inst_tasks );
@@ -600,9 +787,9 @@ void mlite_cpu::mlite() {
 								jump_or_branch = true;
 								r[31] = state->pc;
 								state->pc += imm_shift;
-								mem_address.write(state->pc);
+								bus_address(state->pc);
 							}
-							wait(1);
+							consume(1);
 							
 							branch_inst_kernel=(page != 0? branch_inst_kernel : branch_inst_kernel + 1 );
 							branch_inst_tasks=(page != 0? branch_inst_tasks + 1  : branch_inst_tasks );
@@ -613,9 +800,9 @@ void mlite_cpu::mlite() {
 							if ( r[rs] < 0 ) {
 								jump_or_branch = true;
 								state->pc += imm_shift;
-								mem_address.write(state->pc);
+								bus_address(state->pc);
 							}
-							wait(1);
+							consume(1);
 							
 							branch_inst_kernel=(page != 0? branch_inst_kernel : branch_inst_kernel + 1 );
 							branch_inst_tasks=(page != 0? branch_inst_tasks + 1  : branch_inst_tasks );
@@ -627,9 +814,9 @@ void mlite_cpu::mlite() {
 								jump_or_branch = true;
 								r[31] = state->pc;
 								state->pc += imm_shift;
-								mem_address.write(state->pc);
+								bus_address(state->pc);
 							}
-							wait(1);
+							consume(1);
 							
 							branch_inst_kernel=(page != 0? branch_inst_kernel : branch_inst_kernel + 1 );
 							branch_inst_tasks=(page != 0? branch_inst_tasks + 1  : branch_inst_tasks );
@@ -640,9 +827,9 @@ void mlite_cpu::mlite() {
 							if ( r[rs] >= 0 ) {
 								jump_or_branch = true;
 								state->pc += imm_shift;
-								mem_address.write(state->pc);
+								bus_address(state->pc);
 							}
-							wait(1);
+							consume(1);
 							
 							branch_inst_kernel=(page != 0? branch_inst_kernel : branch_inst_kernel + 1 );
 							branch_inst_tasks=(page != 0? branch_inst_tasks + 1  : branch_inst_tasks );
@@ -660,8 +847,8 @@ void mlite_cpu::mlite() {
 					r[31] = state->pc;
 					state->pc = (state->pc & 0xf0000000) | target;
 					state->pc |= page;				// Adds the page number.
-					mem_address.write(state->pc);
-					wait(1);
+					bus_address(state->pc);
+					consume(1);
 					
 					jump_inst_kernel=(page != 0? jump_inst_kernel : jump_inst_kernel + 1 );
 					jump_inst_tasks=(page != 0? jump_inst_tasks + 1  : jump_inst_tasks );
@@ -672,8 +859,8 @@ void mlite_cpu::mlite() {
 					jump_or_branch = true;
 					state->pc = (state->pc & 0xf0000000) | target;
 					state->pc |= page;				// Adds the page number.
-					mem_address.write(state->pc);
-					wait(1);
+					bus_address(state->pc);
+					consume(1);
 					
 					jump_inst_kernel=(page != 0? jump_inst_kernel : jump_inst_kernel + 1 );
 					jump_inst_tasks=(page != 0? jump_inst_tasks + 1  : jump_inst_tasks );
@@ -684,9 +871,9 @@ void mlite_cpu::mlite() {
 					if ( r[rs] == r[rt] ) {
 						jump_or_branch = true;
 						state->pc += imm_shift;
-						mem_address.write(state->pc);
+						bus_address(state->pc);
 					}
-					wait(1);
+					consume(1);
 					
 					branch_inst_kernel=(page != 0? branch_inst_kernel : branch_inst_kernel + 1 );
 					branch_inst_tasks=(page != 0? branch_inst_tasks + 1  : branch_inst_tasks );
@@ -697,9 +884,9 @@ void mlite_cpu::mlite() {
 					if ( r[rs] != r[rt] ) {
 						jump_or_branch = true;
 						state->pc += imm_shift;
-						mem_address.write(state->pc);
+						bus_address(state->pc);
 					}
-					wait(1);
+					consume(1);
 					
 					branch_inst_kernel=(page != 0? branch_inst_kernel : branch_inst_kernel + 1 );
 					branch_inst_tasks=(page != 0? branch_inst_tasks + 1  : branch_inst_tasks );
@@ -710,9 +897,9 @@ void mlite_cpu::mlite() {
 					if ( r[rs] <= 0 ) {
 						jump_or_branch = true;
 						state->pc += imm_shift;
-						mem_address.write(state->pc);
+						bus_address(state->pc);
 					}
-					wait(1);
+					consume(1);
 					
 					branch_inst_kernel=(page != 0? branch_inst_kernel : branch_inst_kernel + 1 );
 					branch_inst_tasks=(page != 0? branch_inst_tasks + 1  : branch_inst_tasks );
@@ -723,9 +910,9 @@ void mlite_cpu::mlite() {
 					if ( r[rs] > 0 ) {
 						jump_or_branch = true;
 						state->pc += imm_shift;
-						mem_address.write(state->pc);
+						bus_address(state->pc);
 					}
-					wait(1);
+					consume(1);
 					
 					branch_inst_kernel=(page != 0? branch_inst_kernel : branch_inst_kernel + 1 );
 					branch_inst_tasks=(page != 0? branch_inst_tasks + 1  : branch_inst_tasks );
@@ -733,7 +920,7 @@ void mlite_cpu::mlite() {
 				break;
 
 				case 0x08:/*ADDI*/
-					wait(1);
+					consume(1);
 					r[rt] = r[rs] + (short)imm;
 					
 					arith_inst_kernel=(page != 0? arith_inst_kernel : arith_inst_kernel + 1 );
@@ -742,7 +929,7 @@ void mlite_cpu::mlite() {
 				break;
 
 				case 0x09:/*ADDIU*/
-					wait(1);
+					consume(1);
 					u[rt] = u[rs] + (short)imm;
 					
 					arith_inst_kernel=(page != 0? arith_inst_kernel : arith_inst_kernel + 1 );
@@ -751,7 +938,7 @@ void mlite_cpu::mlite() {
 				break;
 
 				case 0x0a:/*SLTI*/
-					wait(1);
+					consume(1);
 					r[rt] = r[rs] < (short)imm;
 					
 					arith_inst_kernel=(page != 0? arith_inst_kernel : arith_inst_kernel + 1 );
@@ -760,7 +947,7 @@ void mlite_cpu::mlite() {
 				break;
 
 				case 0x0b:/*SLTIU*/
-					wait(1);
+					consume(1);
 					u[rt] = u[rs] < (unsigned int)(short)imm;
 					
 					arith_inst_kernel=(page != 0? arith_inst_kernel : arith_inst_kernel + 1 );
@@ -769,7 +956,7 @@ void mlite_cpu::mlite() {
 				break;
 
 				case 0x0c:/*ANDI*/
-					wait(1);
+					consume(1);
 					r[rt] = r[rs] & imm;
 					
 					logical_inst_kernel=(page != 0? logical_inst_kernel : logical_inst_kernel + 1 );
@@ -778,7 +965,7 @@ void mlite_cpu::mlite() {
 				break;
 
 				case 0x0d:/*ORI*/
-					wait(1);
+					consume(1);
 					r[rt] = r[rs] | imm;
 					
 					logical_inst_kernel=(page != 0? logical_inst_kernel : logical_inst_kernel + 1 );
@@ -787,7 +974,7 @@ void mlite_cpu::mlite() {
 				break;
 
 				case 0x0e:/*XORI*/
-					wait(1);
+					consume(1);
 					r[rt] = r[rs] ^ imm;
 					
 					logical_inst_kernel=(page != 0? logical_inst_kernel : logical_inst_kernel + 1 );
@@ -797,7 +984,7 @@ void mlite_cpu::mlite() {
 				break;
 
 				case 0x0f:/*LUI*/
-					wait(1);
+					consume(1);
 					r[rt] = (imm<<16);
 					
 					arith_inst_kernel=(page != 0? arith_inst_kernel : arith_inst_kernel + 1 );
@@ -806,7 +993,7 @@ void mlite_cpu::mlite() {
 				break;
 
 				case 0x10:/*COP0*/
-					wait(1);
+					consume(1);
 					move_inst_kernel=(page != 0? move_inst_kernel : move_inst_kernel + 1 );	
 					move_inst_tasks=(page != 0? move_inst_tasks + 1  : move_inst_tasks );
 							
@@ -866,9 +1053,9 @@ void mlite_cpu::mlite() {
 					if ( r[rs] == r[rt] ) {
 						jump_or_branch = true;
 						state->pc += imm_shift;
-						mem_address.write(state->pc);
+						bus_address(state->pc);
 					}
-					wait(1);
+					consume(1);
 					
 					branch_inst_kernel=(page != 0? branch_inst_kernel : branch_inst_kernel + 1 );
 					branch_inst_tasks=(page != 0? branch_inst_tasks + 1  : branch_inst_tasks );
@@ -879,9 +1066,9 @@ void mlite_cpu::mlite() {
 					if ( r[rs] != r[rt] ) {
 						jump_or_branch = true;
 						state->pc += imm_shift;
-						mem_address.write(state->pc);
+						bus_address(state->pc);
 					}
-					wait(1);
+					consume(1);
 					
 					branch_inst_kernel=(page != 0? branch_inst_kernel : branch_inst_kernel + 1 );
 					branch_inst_tasks=(page != 0? branch_inst_tasks + 1  : branch_inst_tasks );
@@ -892,9 +1079,9 @@ void mlite_cpu::mlite() {
 					if ( r[rs] <= 0 ) {
 						jump_or_branch = true;
 						state->pc += imm_shift;
-						mem_address.write(state->pc);
+						bus_address(state->pc);
 					}
-					wait(1);
+					consume(1);
 					
 					branch_inst_kernel=(page != 0? branch_inst_kernel : branch_inst_kernel + 1 );
 					branch_inst_tasks=(page != 0? branch_inst_tasks + 1  : branch_inst_tasks );
@@ -905,9 +1092,9 @@ void mlite_cpu::mlite() {
 					if ( r[rs] > 0 ) {
 						jump_or_branch = true;
 						state->pc += imm_shift;
-						mem_address.write(state->pc);
+						bus_address(state->pc);
 					}
-					wait(1);
+					consume(1);
 					
 					branch_inst_kernel=(page != 0? branch_inst_kernel : branch_inst_kernel + 1 );
 					branch_inst_tasks=(page != 0? branch_inst_tasks + 1  : branch_inst_tasks );
@@ -917,257 +1104,257 @@ void mlite_cpu::mlite() {
 		//      case 0x1c:/*MAD*/  break;   /*IV*/
 
 				case 0x20:/*LB*/
-					mem_address.write(ptr & word_addr);	// Address the memory with word address.
-					wait(1);
+					bus_address(ptr & word_addr);	// Address the memory with word address.
+					consume(1);
 					
 					load_inst_kernel=(page != 0? load_inst_kernel : load_inst_kernel + 1 );
 					load_inst_tasks=(page != 0? load_inst_tasks + 1  : load_inst_tasks );
 
 					// Verifies the mem_pause signal at the first execution cycle
 					if ( mem_pause.read() ) {
-						mem_address.write(pc_last);	// Keep the last memory address before mem_pause = '1'
+						bus_address(pc_last);	// Keep the last memory address before mem_pause = '1'
 
 						while (mem_pause.read())	// Stalls the CPU while mem_pause = '1'
-							wait(1);
+							consume(1);
 
-						mem_address.write(ptr & word_addr);// Address the memory with word address.
-						wait(1);
+						bus_address(ptr & word_addr);// Address the memory with word address.
+						consume(1);
 					}
 
 					prefetch = true;
-					prefetched_opcode = mem_data_r.read();
-					mem_address.write(state->pc);
-					wait(1);
+					prefetched_opcode = bus_read();
+					bus_address(state->pc);
+					consume(1);
 
 					// Verifies the mem_pause signal at the second execution cycle
 					if (mem_pause.read()) {
-						mem_address.write(ptr & word_addr);// Keep the last memory address before mem_pause = '1'
+						bus_address(ptr & word_addr);// Keep the last memory address before mem_pause = '1'
 
 						while (mem_pause.read())	// Stalls the CPU while mem_pause = '1'
-							wait(1);
+							consume(1);
 
-						mem_address.write(state->pc);// Address the next instruction
-						wait(1);
+						bus_address(state->pc);// Address the next instruction
+						consume(1);
 					}
 
 					if ((ptr & 3) == 3)
 						if (big_endian)
-							r[rt] = (char)mem_data_r.read().range(7,0);
+							r[rt] = (char)bus_read().range(7,0);
 						else
-							r[rt] = (char)mem_data_r.read().range(31,24);
+							r[rt] = (char)bus_read().range(31,24);
 
 					else if ((ptr & 2) == 2)
 						if (big_endian)
-							r[rt] = (char)mem_data_r.read().range(15,8);
+							r[rt] = (char)bus_read().range(15,8);
 						else
-							r[rt] = (char)mem_data_r.read().range(23,16);
+							r[rt] = (char)bus_read().range(23,16);
 
 					else if ((ptr & 1) == 1)
 						if (big_endian)
-							r[rt] = (char)mem_data_r.read().range(23,16);
+							r[rt] = (char)bus_read().range(23,16);
 						else
-							r[rt] = (char)mem_data_r.read().range(15,8);
+							r[rt] = (char)bus_read().range(15,8);
 
 					else
 						if (big_endian)
-							r[rt] = (char)mem_data_r.read().range(31,24);
+							r[rt] = (char)bus_read().range(31,24);
 						else
-							r[rt] = (char)mem_data_r.read().range(7,0);
+							r[rt] = (char)bus_read().range(7,0);
 
 
 				break;
 
 				case 0x21:/*LH*/
 					//assert((ptr & 1) == 0);
-					mem_address.write(ptr & word_addr);	// Address the memory with word address.
-					wait(1);
+					bus_address(ptr & word_addr);	// Address the memory with word address.
+					consume(1);
 					load_inst_kernel=(page != 0? load_inst_kernel : load_inst_kernel + 1 );
 					load_inst_tasks=(page != 0? load_inst_tasks + 1  : load_inst_tasks );
 
 					// Verifies the mem_pause signal at the first execution cycle
 					if ( mem_pause.read() ) {
-						mem_address.write(pc_last);	// Keep the last memory address before mem_pause = '1'
+						bus_address(pc_last);	// Keep the last memory address before mem_pause = '1'
 
 						while (mem_pause.read())	// Stalls the CPU while mem_pause = '1'
-							wait(1);
+							consume(1);
 
-						mem_address.write(ptr & word_addr);// Address the memory with word address.
-						wait(1);
+						bus_address(ptr & word_addr);// Address the memory with word address.
+						consume(1);
 					}
 
 					prefetch = true;
-					prefetched_opcode = mem_data_r.read();
-					mem_address.write(state->pc);
-					wait(1);
+					prefetched_opcode = bus_read();
+					bus_address(state->pc);
+					consume(1);
 
 					// Verifies the mem_pause signal at the second execution cycle
 					if (mem_pause.read()) {
-						mem_address.write(ptr & word_addr);// Keep the last memory address before mem_pause = '1'
+						bus_address(ptr & word_addr);// Keep the last memory address before mem_pause = '1'
 
 						while (mem_pause.read())	// Stalls the CPU while mem_pause = '1'
-							wait(1);
+							consume(1);
 
-						mem_address.write(state->pc);// Address the next instruction
-						wait(1);
+						bus_address(state->pc);// Address the next instruction
+						consume(1);
 					}
 
 					if ((ptr & 2) == 2)
 						if (big_endian)
-							r[rt] = (short)mem_data_r.read().range(15,0);
+							r[rt] = (short)bus_read().range(15,0);
 						else
-							r[rt] = (short)mem_data_r.read().range(31,16);
+							r[rt] = (short)bus_read().range(31,16);
 					else
 						if (big_endian)
-							r[rt] = (short)mem_data_r.read().range(31,16);
+							r[rt] = (short)bus_read().range(31,16);
 						else
-							r[rt] = (short)mem_data_r.read().range(15,0);
+							r[rt] = (short)bus_read().range(15,0);
 				break;
 
 				case 0x22:/*LWL*/  rt=rt; //fixme fall through
 				case 0x23:/*LW*/
 					//assert((ptr & 3) == 0);
-					mem_address.write(ptr & word_addr);	// Address the memory with word address.
-					wait(1);
+					bus_address(ptr & word_addr);	// Address the memory with word address.
+					consume(1);
 					
 					load_inst_kernel=(page != 0? load_inst_kernel : load_inst_kernel + 1 );
 					load_inst_tasks=(page != 0? load_inst_tasks + 1  : load_inst_tasks );
 
 					// Verifies the mem_pause signal at the first execution cycle
 					if ( mem_pause.read() ) {
-						mem_address.write(pc_last);	// Keep the last memory address before mem_pause = '1'
-						wait(1);
+						bus_address(pc_last);	// Keep the last memory address before mem_pause = '1'
+						consume(1);
 						while (mem_pause.read())	// Stalls the CPU while mem_pause = '1'
-							wait(1);
+							consume(1);
 
-						mem_address.write(ptr & word_addr);// Address the memory with word address.
-						wait(1);
+						bus_address(ptr & word_addr);// Address the memory with word address.
+						consume(1);
 					}
 
 					prefetch = true;
-					prefetched_opcode = mem_data_r.read();
-					mem_address.write(state->pc);
-					wait(1);
+					prefetched_opcode = bus_read();
+					bus_address(state->pc);
+					consume(1);
 
 					// Verifies the mem_pause signal at the second execution cycle
 					if (mem_pause.read()) {
-						mem_address.write(ptr & word_addr);// Keep the last memory address before mem_pause = '1'
+						bus_address(ptr & word_addr);// Keep the last memory address before mem_pause = '1'
 
 						while (mem_pause.read())	// Stalls the CPU while mem_pause = '1'
-							wait(1);
+							consume(1);
 
-						mem_address.write(state->pc);// Address the next instruction
-						wait(1);
+						bus_address(state->pc);// Address the next instruction
+						consume(1);
 					}
 
-					r[rt] = mem_data_r.read();
+					r[rt] = bus_read();
 				break;
 
 				case 0x24:/*LBU*/
-					mem_address.write(ptr & word_addr);	// Address the memory with word address.
-					wait(1);
+					bus_address(ptr & word_addr);	// Address the memory with word address.
+					consume(1);
 					load_inst_kernel=(page != 0? load_inst_kernel : load_inst_kernel + 1 );
 					load_inst_tasks=(page != 0? load_inst_tasks + 1  : load_inst_tasks );
 
 					// Verifies the mem_pause signal at the first execution cycle
 					if ( mem_pause.read() ) {
-						mem_address.write(pc_last);	// Keep the last memory address before mem_pause = '1'
+						bus_address(pc_last);	// Keep the last memory address before mem_pause = '1'
 
 						while (mem_pause.read())	// Stalls the CPU while mem_pause = '1'
-							wait(1);
+							consume(1);
 
-						mem_address.write(ptr & word_addr);// Address the memory with word address.
-						wait(1);
+						bus_address(ptr & word_addr);// Address the memory with word address.
+						consume(1);
 					}
 
 					prefetch = true;
-					prefetched_opcode = mem_data_r.read();
-					mem_address.write(state->pc);
-					wait(1);
+					prefetched_opcode = bus_read();
+					bus_address(state->pc);
+					consume(1);
 
 					// Verifies the mem_pause signal at the second execution cycle
 					if (mem_pause.read()) {
-						mem_address.write(ptr & word_addr);// Keep the last memory address before mem_pause = '1'
+						bus_address(ptr & word_addr);// Keep the last memory address before mem_pause = '1'
 
 						while (mem_pause.read())	// Stalls the CPU while mem_pause = '1'
-							wait(1);
+							consume(1);
 
-						mem_address.write(state->pc);// Address the next instruction
-						wait(1);
+						bus_address(state->pc);// Address the next instruction
+						consume(1);
 					}
 
 					if ((ptr & 3) == 3)
 						if (big_endian)
-								r[rt] = (unsigned char)mem_data_r.read().range(7,0);
+								r[rt] = (unsigned char)bus_read().range(7,0);
 							else
-								r[rt] = (unsigned char)mem_data_r.read().range(31,24);
+								r[rt] = (unsigned char)bus_read().range(31,24);
 
 						else if ((ptr & 2) == 2)
 							if (big_endian)
-								r[rt] = (unsigned char)mem_data_r.read().range(15,8);
+								r[rt] = (unsigned char)bus_read().range(15,8);
 							else
-								r[rt] = (unsigned char)mem_data_r.read().range(23,16);
+								r[rt] = (unsigned char)bus_read().range(23,16);
 
 						else if ((ptr & 1) == 1)
 							if (big_endian)
-								r[rt] = (unsigned char)mem_data_r.read().range(23,16);
+								r[rt] = (unsigned char)bus_read().range(23,16);
 							else
-								r[rt] = (unsigned char)mem_data_r.read().range(15,8);
+								r[rt] = (unsigned char)bus_read().range(15,8);
 
 						else
 							if (big_endian)
-								r[rt] = (unsigned char)mem_data_r.read().range(31,24);
+								r[rt] = (unsigned char)bus_read().range(31,24);
 							else
-								r[rt] = (unsigned char)mem_data_r.read().range(7,0);
+								r[rt] = (unsigned char)bus_read().range(7,0);
 				break;
 
 				case 0x25:/*LHU*/
 					//assert((ptr & 1) == 0);
-					mem_address.write(ptr & word_addr);	// Address the memory with word address.
-					wait(1);
+					bus_address(ptr & word_addr);	// Address the memory with word address.
+					consume(1);
 					load_inst_kernel=(page != 0? load_inst_kernel : load_inst_kernel + 1 );
 					load_inst_tasks=(page != 0? load_inst_tasks + 1  : load_inst_tasks );
 
 					// Verifies the mem_pause signal at the first execution cycle
 					if ( mem_pause.read() ) {
-						mem_address.write(pc_last);	// Keep the last memory address before mem_pause = '1'
-						wait(1);
+						bus_address(pc_last);	// Keep the last memory address before mem_pause = '1'
+						consume(1);
 						while (mem_pause.read())	// Stalls the CPU while mem_pause = '1'
-							wait(1);
+							consume(1);
 
-						mem_address.write(ptr & word_addr);// Address the memory with word address.
-						wait(1);
+						bus_address(ptr & word_addr);// Address the memory with word address.
+						consume(1);
 					}
 
 					prefetch = true;
-					prefetched_opcode = mem_data_r.read();
-					mem_address.write(state->pc);
-					wait(1);
+					prefetched_opcode = bus_read();
+					bus_address(state->pc);
+					consume(1);
 
 					// Verifies the mem_pause signal at the second execution cycle
 					if (mem_pause.read()) {
-						mem_address.write(ptr & word_addr);// Keep the last memory address before mem_pause = '1'
+						bus_address(ptr & word_addr);// Keep the last memory address before mem_pause = '1'
 
 						while (mem_pause.read())	// Stalls the CPU while mem_pause = '1'
-							wait(1);
+							consume(1);
 
-						mem_address.write(state->pc);// Address the next instruction
-						wait(1);
+						bus_address(state->pc);// Address the next instruction
+						consume(1);
 					}
 
 					if ((ptr & 2) == 2)
 						if (big_endian)
-							r[rt] = (unsigned short)mem_data_r.read().range(15,0);
+							r[rt] = (unsigned short)bus_read().range(15,0);
 						else
-							r[rt] = (unsigned short)mem_data_r.read().range(31,16);
+							r[rt] = (unsigned short)bus_read().range(31,16);
 					else
 						if (big_endian)
-							r[rt] = (unsigned short)mem_data_r.read().range(31,16);
+							r[rt] = (unsigned short)bus_read().range(31,16);
 						else
-							r[rt] = ( unsigned short)mem_data_r.read().range(15,0);
+							r[rt] = ( unsigned short)bus_read().range(15,0);
 				break;
 
 				case 0x26:/*LWR*/  
-					wait(1); 
+					consume(1); 
 					load_inst_kernel=(page != 0? load_inst_kernel : load_inst_kernel + 1 );
 					load_inst_tasks=(page != 0? load_inst_tasks + 1  : load_inst_tasks );
 
@@ -1175,8 +1362,8 @@ void mlite_cpu::mlite() {
 
 				case 0x28:/*SB*/
 					byte_write = r[rt] & 0x000000FF;	/* Retrieves the byte to be stored */
-					mem_address.write(ptr & word_addr);	// Address the memory with word address.
-					mem_data_w.write((byte_write<<24) | (byte_write<<16) | (byte_write<<8) | byte_write);
+					bus_address(ptr & word_addr);	// Address the memory with word address.
+					bus_data((byte_write<<24) | (byte_write<<16) | (byte_write<<8) | byte_write);
 
 					if ((ptr & 3) == 3)
 						if (big_endian)
@@ -1202,38 +1389,38 @@ void mlite_cpu::mlite() {
 						else
 							byte_en = 0x1;
 
-					mem_byte_we.write(byte_en);
+					bus_byte_we(byte_en);
 
-					wait(1);
+					consume(1);
 
 					// Verifies the mem_pause signal at the first execution cycle
 					if ( mem_pause ) {
-						mem_address.write(pc_last);// Keep the last memory address before mem_pause = '1'
-						mem_byte_we.write(0);// Disable write
+						bus_address(pc_last);// Keep the last memory address before mem_pause = '1'
+						bus_byte_we(0);// Disable write
 
 						while (mem_pause)	// Stalls the CPU while mem_pause = '1'
-							wait(1);
+							consume(1);
 
-						mem_address.write(ptr & word_addr);	// Address the memory with word address.
-						mem_byte_we.write(byte_en);			// Enable write
-						wait(1);
+						bus_address(ptr & word_addr);	// Address the memory with word address.
+						bus_byte_we(byte_en);			// Enable write
+						consume(1);
 					}
 
-					mem_byte_we.write(0x0);
+					bus_byte_we(0x0);
 					prefetch = true;
-					prefetched_opcode = mem_data_r.read();
-					mem_address.write(state->pc);
-					wait(1);
+					prefetched_opcode = bus_read();
+					bus_address(state->pc);
+					consume(1);
 
 					// Verifies the mem_pause signal at the second execution cycle
 					if (mem_pause) {
-						mem_address.write(ptr & word_addr);// Keep the last memory address before mem_pause = '1'
+						bus_address(ptr & word_addr);// Keep the last memory address before mem_pause = '1'
 
 						while (mem_pause)	// Stalls the CPU while mem_pause = '1'
-							wait(1);
+							consume(1);
 
-						mem_address.write(state->pc);// Address the next instruction
-						wait(1);
+						bus_address(state->pc);// Address the next instruction
+						consume(1);
 					}
 					
 					load_inst_kernel=(page != 0? load_inst_kernel : load_inst_kernel + 1 );
@@ -1242,8 +1429,8 @@ void mlite_cpu::mlite() {
 
 				case 0x29:/*SH*/
 					byte_write = r[rt] & 0x0000FFFF;	/* Retrieves the half word to be stored */
-					mem_address.write(ptr & word_addr);	// Address the memory with word address.
-					mem_data_w.write((byte_write<<16) | byte_write);
+					bus_address(ptr & word_addr);	// Address the memory with word address.
+					bus_data((byte_write<<16) | byte_write);
 
 					if ((ptr & 2) == 2)
 						if (big_endian)
@@ -1256,38 +1443,38 @@ void mlite_cpu::mlite() {
 						else
 							byte_en = 0x3;
 
-					mem_byte_we.write(byte_en);
+					bus_byte_we(byte_en);
 
-					wait(1);
+					consume(1);
 
 					// Verifies the mem_pause signal at the first execution cycle
 					if ( mem_pause ) {
-						mem_address.write(pc_last);// Keep the last memory address before mem_pause = '1'
-						mem_byte_we.write(0);// Disable write
+						bus_address(pc_last);// Keep the last memory address before mem_pause = '1'
+						bus_byte_we(0);// Disable write
 
 						while (mem_pause)	// Stalls the CPU while mem_pause = '1'
-							wait(1);
+							consume(1);
 
-						mem_address.write(ptr & word_addr);	// Address the memory with word address.
-						mem_byte_we.write(byte_en);			// Enable write
-						wait(1);
+						bus_address(ptr & word_addr);	// Address the memory with word address.
+						bus_byte_we(byte_en);			// Enable write
+						consume(1);
 					}
 
-					mem_byte_we.write(0x0);
+					bus_byte_we(0x0);
 					prefetch = true;
-					prefetched_opcode = mem_data_r.read();
-					mem_address.write(state->pc);
-					wait(1);
+					prefetched_opcode = bus_read();
+					bus_address(state->pc);
+					consume(1);
 
 					// Verifies the mem_pause signal at the second execution cycle
 					if (mem_pause) {
-						mem_address.write(ptr & word_addr);// Keep the last memory address before mem_pause = '1'
+						bus_address(ptr & word_addr);// Keep the last memory address before mem_pause = '1'
 
 						while (mem_pause)	// Stalls the CPU while mem_pause = '1'
-							wait(1);
+							consume(1);
 
-						mem_address.write(state->pc);// Address the next instruction
-						wait(1);
+						bus_address(state->pc);// Address the next instruction
+						consume(1);
 					}
 					load_inst_kernel=(page != 0? load_inst_kernel : load_inst_kernel + 1 );
 					load_inst_tasks=(page != 0? load_inst_tasks + 1  : load_inst_tasks );
@@ -1297,38 +1484,38 @@ void mlite_cpu::mlite() {
 				case 0x2a:/*SWL*/  rt=rt; //fixme fall through
 				case 0x2b:/*SW*/
 					//assert((ptr & 3) == 0);
-					mem_address.write(ptr);
-					mem_data_w.write(r[rt]);
-					mem_byte_we.write(0xF);
-					wait(1);
+					bus_address(ptr);
+					bus_data(r[rt]);
+					bus_byte_we(0xF);
+					consume(1);
 
 					// Verifies the mem_pause signal at the first execution cycle
 					if ( mem_pause ) {
-						mem_address.write(pc_last);// Keep the last memory address before mem_pause = '1'
-						mem_byte_we.write(0);// Disable write
+						bus_address(pc_last);// Keep the last memory address before mem_pause = '1'
+						bus_byte_we(0);// Disable write
 
 						while (mem_pause)	// Stalls the CPU while mem_pause = '1'
-							wait(1);
+							consume(1);
 
-						mem_address.write(ptr & word_addr);	// Address the memory with word address.
-						mem_byte_we.write(0xF);			// Enable write
-						wait(1);
+						bus_address(ptr & word_addr);	// Address the memory with word address.
+						bus_byte_we(0xF);			// Enable write
+						consume(1);
 					}
 
-					mem_byte_we.write(0x0);
+					bus_byte_we(0x0);
 					prefetch = true;
-					prefetched_opcode = mem_data_r.read();
-					mem_address.write(state->pc);
-					wait(1);
+					prefetched_opcode = bus_read();
+					bus_address(state->pc);
+					consume(1);
 
 					// Verifies the mem_pause signal at the second execution cycle
 					if (mem_pause) {
-						mem_address.write(ptr & word_addr);// Keep the last memory address before mem_pause = '1'
+						bus_address(ptr & word_addr);// Keep the last memory address before mem_pause = '1'
 						while (mem_pause)	// Stalls the CPU while mem_pause = '1'
-							wait(1);
+							consume(1);
 
-						mem_address.write(state->pc);// Address the next instruction
-						wait(1);
+						bus_address(state->pc);// Address the next instruction
+						consume(1);
 					}
 					load_inst_kernel=(page != 0? load_inst_kernel : load_inst_kernel + 1 );
 					load_inst_tasks=(page != 0? load_inst_tasks + 1  : load_inst_tasks );
@@ -1336,13 +1523,13 @@ void mlite_cpu::mlite() {
 				break;
 
 				case 0x2e:/*SWR*/  
-					wait(1); 
+					consume(1); 
 					other_inst_kernel=(page != 0? other_inst_kernel : other_inst_kernel + 1 );
 					other_inst_tasks=(page != 0? other_inst_tasks + 1  : other_inst_tasks );
 
 				break; //fixme
 				case 0x2f:/*CACHE*/
-					wait(1); 
+					consume(1); 
 					other_inst_kernel=(page != 0? other_inst_kernel : other_inst_kernel + 1 );
 					other_inst_tasks=(page != 0? other_inst_tasks + 1  : other_inst_tasks );
 
@@ -1350,15 +1537,15 @@ void mlite_cpu::mlite() {
 
 				case 0x30:/*LL*/
 					//assert((ptr & 3) == 0);
-					mem_address.write(ptr);
-					wait(1);
+					bus_address(ptr);
+					consume(1);
 
 					prefetch = true;
-					prefetched_opcode = mem_data_r.read();
-					mem_address.write(state->pc);
-					wait(1);
+					prefetched_opcode = bus_read();
+					bus_address(state->pc);
+					consume(1);
 
-					r[rt] = mem_data_r.read();
+					r[rt] = bus_read();
 					
 					load_inst_kernel=(page != 0? load_inst_kernel : load_inst_kernel + 1 );
 					load_inst_tasks=(page != 0? load_inst_tasks + 1  : load_inst_tasks );
@@ -1375,16 +1562,16 @@ void mlite_cpu::mlite() {
 
 				case 0x38:/*SC*/
 					//assert((ptr & 3) == 0);
-					mem_address.write(ptr);
-					mem_data_w.write(r[rt]);
-					mem_byte_we.write(0xF);
-					wait(1);
+					bus_address(ptr);
+					bus_data(r[rt]);
+					bus_byte_we(0xF);
+					consume(1);
 
-					mem_byte_we.write(0x0);
+					bus_byte_we(0x0);
 					prefetch = true;
-					prefetched_opcode = mem_data_r.read();
-					mem_address.write(state->pc);
-					wait(1);
+					prefetched_opcode = bus_read();
+					bus_address(state->pc);
+					consume(1);
 
 					r[rt] = 1;
 					
@@ -1394,7 +1581,7 @@ void mlite_cpu::mlite() {
 				break;
 		//
 				case 0x39:/*SWC1*/ 
-					wait(1); 
+					consume(1); 
 					other_inst_kernel=(page != 0? other_inst_kernel : other_inst_kernel + 1 );
 					other_inst_tasks=(page != 0? other_inst_tasks + 1  : other_inst_tasks );
 
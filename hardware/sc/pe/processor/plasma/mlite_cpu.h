@@ -22,6 +22,7 @@
 #include <assert.h>
 #include <math.h>
 #include "../../../standards.h"
+#include "../../memory/ram.h"
 
 
   #define TAM_FLIT 32
@@ -104,9 +105,31 @@ SC_MODULE(mlite_cpu) {
    	  unsigned long int nop_inst_tasks;
 	  unsigned long int mult_div_inst_tasks;
  
+	/*** DMI and temporal decoupling ***/
+	ram *dmi_ram;
+	unsigned int dmi_words, dmi_page;
+	unsigned int quantum, local_cycles;
+	unsigned int bus_data_w, bus_sync;
+	sc_uint<4> bus_we;
+	int bus_index, bus_index_1, bus_index_2;	// RAM word on the bus at this and the two previous cycles. -1 if not in RAM
+
 	/*** Process function ***/
 	void mlite();
 
+	/*** DMI and temporal decoupling ***/
+	void set_dmi(ram *ram_, unsigned int words_);
+	void set_quantum(unsigned int cycles_);
+	int dmi_index(unsigned int address);
+	void bus_address(unsigned int address);
+	void bus_data(unsigned int data);
+	void bus_byte_we(sc_uint<4> we);
+	sc_uint<32> bus_read();
+	void consume(unsigned int cycles);
+	void sync();
+
+	/*** Checkpoint ***/
+	void checkpoint(Checkpoint &ckp);
+
 	/*** Helper functions ***/
 	void mult_big(unsigned int a, unsigned int b);
 	void mult_big_signed(int a, int b);
@@ -122,6 +145,16 @@ SC_MODULE(mlite_cpu) {
 
 		state = &state_instance;
 
+		dmi_ram = NULL;
+		dmi_words = 0;
+		dmi_page = 0;
+		quantum = 0;
+		local_cycles = 0;
+		bus_data_w = 0;
+		bus_sync = 0;
+		bus_we = 0;
+		bus_index = bus_index_1 = bus_index_2 = -1;
+
 		// MIPS: Big endian.
 		big_endian = 1;
 
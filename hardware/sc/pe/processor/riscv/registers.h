@@ -16,7 +16,74 @@
 #include <cmath>
 
 static const uint32_t XLEN = 32;
+
+/* Mask of the bits l down to r of T */
+template <typename T>
+constexpr T bit_mask(int l, int r) { return ((T)~(T)0 >> (sizeof(T)*8 - 1 - (l - r))) << r; }
+
+/* Bit-slice and single bit proxies over a native integer, as returned by range() and bit() */
+template <typename T>
+class NativeSubref {
+private:
+	T &v;
+	T mask;
+	int r;
+
+public:
+	NativeSubref(T &v_, int l_, int r_) : v(v_), mask(bit_mask<T>(l_, r_)), r(r_) { }
+	operator uint64_t() const { return (v & mask) >> r; }
+	NativeSubref& operator=(uint64_t value) { v = (v & ~mask) | (((T)value << r) & mask); return *this; }
+	NativeSubref& operator=(const NativeSubref &ref) { return *this = (uint64_t)ref; }
+};
+
+template <typename T>
+class NativeBitref {
+private:
+	T &v;
+	int b;
+
+public:
+	NativeBitref(T &v_, int b_) : v(v_), b(b_) { }
+	operator bool() const { return (v >> b) & 1; }
+	NativeBitref& operator=(bool value) { v = (v & ~((T)1 << b)) | ((T)value << b); return *this; }
+	NativeBitref& operator=(const NativeBitref &ref) { return *this = (bool)ref; }
+};
+
+/* W-bit unsigned integer stored in T with the sc_uint<W> semantics used by the ISS */
+template <int W, typename T>
+class NativeUint {
+private:
+	static constexpr T MASK = bit_mask<T>(W - 1, 0);
+	T v;
+
+public:
+	NativeUint() : v(0) { }
+	template <typename V> NativeUint(const V &value) : v((uint64_t)value & MASK) { }
+	template <typename V> NativeUint& operator=(const V &value) { v = (uint64_t)value & MASK; return *this; }
+	NativeUint& operator+=(uint64_t value) { v = (v + value) & MASK; return *this; }
+	operator uint64_t() const { return v; }
+
+	NativeSubref<T> range(int l, int r) { return NativeSubref<T>(v, l, r); }
+	NativeBitref<T> bit(int b) { return NativeBitref<T>(v, b); }
+};
+
+/**
+ * Registers are native integers unless SC_DT_REGISTERS is defined, which
+ * falls back to sc_uint and its pooled sc_dt proxies.
+ */
+#ifdef SC_DT_REGISTERS
 typedef sc_uint<XLEN> xlenreg_t;
+typedef sc_uint<34> paddr_t;
+typedef sc_dt::sc_uint_subref subref_t;
+typedef sc_dt::sc_uint_bitref bitref_t;
+typedef sc_dt::sc_uint_subref paddr_subref_t;
+#else
+typedef NativeUint<XLEN, uint32_t> xlenreg_t;
+typedef NativeUint<34, uint64_t> paddr_t;
+typedef NativeSubref<uint32_t> subref_t;
+typedef NativeBitref<uint32_t> bitref_t;
+typedef NativeSubref<uint64_t> paddr_subref_t;
+#endif
 
 class Privilege {
 public:
@@ -43,8 +110,8 @@ public:
 	Register(const Register &Reg) : reg(Reg.reg) { }
 	void write(xlenreg_t value) { reg = value; }
 	xlenreg_t read() { return reg; }
-	sc_dt::sc_uint_subref range(int l, int r) { return reg.range(l, r); }
-	sc_dt::sc_uint_bitref bit(int b) { return reg.bit(b); }
+	subref_t range(int l, int r) { return reg.range(l, r); }
+	bitref_t bit(int b) { return reg.bit(b); }
 };
 
 namespace ISA {
@@ -74,27 +141,27 @@ namespace ISA {
 
 	class Misa : public Register {
 	public:
-		sc_dt::sc_uint_bitref X() { return reg.bit(22); }
-		sc_dt::sc_uint_bitref V() { return reg.bit(21); }
-		sc_dt::sc_uint_bitref U() { return reg.bit(20); }
-		sc_dt::sc_uint_bitref T() { return reg.bit(19); }
-		sc_dt::sc_uint_bitref S() { return reg.bit(18); }
-		sc_dt::sc_uint_bitref Q() { return reg.bit(16); }
-		sc_dt::sc_uint_bitref P() { return reg.bit(15); }
-		sc_dt::sc_uint_bitref N() { return reg.bit(13); }
-		sc_dt::sc_uint_bitref M() { return reg.bit(12); }
-		sc_dt::sc_uint_bitref L() { return reg.bit(11); }
-		sc_dt::sc_uint_bitref K() { return reg.bit(10); }
-		sc_dt::sc_uint_bitref J() { return reg.bit(9); }
-		sc_dt::sc_uint_bitref I() { return reg.bit(8); }
-		sc_dt::sc_uint_bitref H() { return reg.bit(7); }
-		sc_dt::sc_uint_bitref G() { return reg.bit(6); }
-		sc_dt::sc_uint_bitref F() { return reg.bit(5); }
-		sc_dt::sc_uint_bitref E() { return reg.bit(4); }
-		sc_dt::sc_uint_bitref D() { return reg.bit(3); }
-		sc_dt::sc_uint_bitref C() { return reg.bit(2); }
-		sc_dt::sc_uint_bitref B() { return reg.bit(1); }
-		sc_dt::sc_uint_bitref A() { return reg.bit(0); }
+		bitref_t X() { return reg.bit(22); }
+		bitref_t V() { return reg.bit(21); }
+		bitref_t U() { return reg.bit(20); }
+		bitref_t T() { return reg.bit(19); }
+		bitref_t S() { return reg.bit(18); }
+		bitref_t Q() { return reg.bit(16); }
+		bitref_t P() { return reg.bit(15); }
+		bitref_t N() { return reg.bit(13); }
+		bitref_t M() { return reg.bit(12); }
+		bitref_t L() { return reg.bit(11); }
+		bitref_t K() { return reg.bit(10); }
+		bitref_t J() { return reg.bit(9); }
+		bitref_t I() { return reg.bit(8); }
+		bitref_t H() { return reg.bit(7); }
+		bitref_t G() { return reg.bit(6); }
+		bitref_t F() { return reg.bit(5); }
+		bitref_t E() { return reg.bit(4); }
+		bitref_t D() { return reg.bit(3); }
+		bitref_t C() { return reg.bit(2); }
+		bitref_t B() { return reg.bit(1); }
+		bitref_t A() { return reg.bit(0); }
 	};
 };
 
@@ -219,31 +286,31 @@ public:
 	void write(xlenreg_t value) { reg = (value & MASK);  }
 	xlenreg_t read() { return (reg & MASK); }
 
-	sc_dt::sc_uint_bitref SD() { return reg.bit(31); }
-	sc_dt::sc_uint_bitref TSR() { return reg.bit(22); }
-	sc_dt::sc_uint_bitref TW() { return reg.bit(21); }
-	sc_dt::sc_uint_bitref TVM() { return reg.bit(20); }
-	sc_dt::sc_uint_bitref MXR() { return reg.bit(19); }
-	sc_dt::sc_uint_bitref SUM() { return reg.bit(18); }
-	sc_dt::sc_uint_bitref MPRV() { return reg.bit(17); }
-	sc_dt::sc_uint_subref XS() { return reg.range(16, 15); }
-	sc_dt::sc_uint_subref FS() { return reg.range(14, 13); }
-	sc_dt::sc_uint_subref MPP() { return reg.range(12, 11); }
-	sc_dt::sc_uint_bitref SPP() { return reg.bit(8); }
-	sc_dt::sc_uint_bitref MPIE() { return reg.bit(7); }
-	sc_dt::sc_uint_bitref SPIE() { return reg.bit(5); }
-	sc_dt::sc_uint_bitref UPIE() { return reg.bit(4); }
-	sc_dt::sc_uint_bitref MIE() { return reg.bit(3); }
-	sc_dt::sc_uint_bitref SIE() { return reg.bit(1); }
-	sc_dt::sc_uint_bitref UIE() { return reg.bit(0); }
+	bitref_t SD() { return reg.bit(31); }
+	bitref_t TSR() { return reg.bit(22); }
+	bitref_t TW() { return reg.bit(21); }
+	bitref_t TVM() { return reg.bit(20); }
+	bitref_t MXR() { return reg.bit(19); }
+	bitref_t SUM() { return reg.bit(18); }
+	bitref_t MPRV() { return reg.bit(17); }
+	subref_t XS() { return reg.range(16, 15); }
+	subref_t FS() { return reg.range(14, 13); }
+	subref_t MPP() { return reg.range(12, 11); }
+	bitref_t SPP() { return reg.bit(8); }
+	bitref_t MPIE() { return reg.bit(7); }
+	bitref_t SPIE() { return reg.bit(5); }
+	bitref_t UPIE() { return reg.bit(4); }
+	bitref_t MIE() { return reg.bit(3); }
+	bitref_t SIE() { return reg.bit(1); }
+	bitref_t UIE() { return reg.bit(0); }
 };
 
 // @todo Misa. Hard because has some WARL
 
 class Mcause : public Register {
 public:
-	sc_dt::sc_uint_bitref interrupt() { return reg.bit(31); }
-	sc_dt::sc_uint_subref exception_code() { return reg.range(30, 0); }
+	bitref_t interrupt() { return reg.bit(31); }
+	subref_t exception_code() { return reg.range(30, 0); }
 };
 
 namespace Interrupts {
@@ -286,15 +353,15 @@ namespace Interrupts {
 		void write(xlenreg_t value) { reg = (value & MASK);  }
 		xlenreg_t read() { return (reg & MASK); }
 
-		sc_dt::sc_uint_bitref MEI() { return reg.bit(11); }
-		sc_dt::sc_uint_bitref SEI() { return reg.bit(9); }
-		//sc_dt::sc_uint_bitref UEI() { return reg.bit(8); }
-		sc_dt::sc_uint_bitref MTI() { return reg.bit(7); }
-		sc_dt::sc_uint_bitref STI() { return reg.bit(5); }
-		//sc_dt::sc_uint_bitref UTI() { return reg.bit(4); }
-		sc_dt::sc_uint_bitref MSI() { return reg.bit(3); }
-		sc_dt::sc_uint_bitref SSI() { return reg.bit(1); }
-		//sc_dt::sc_uint_bitref USI() { return reg.bit(0); }
+		bitref_t MEI() { return reg.bit(11); }
+		bitref_t SEI() { return reg.bit(9); }
+		//bitref_t UEI() { return reg.bit(8); }
+		bitref_t MTI() { return reg.bit(7); }
+		bitref_t STI() { return reg.bit(5); }
+		//bitref_t UTI() { return reg.bit(4); }
+		bitref_t MSI() { return reg.bit(3); }
+		bitref_t SSI() { return reg.bit(1); }
+		//bitref_t USI() { return reg.bit(0); }
 	};
 };
 
@@ -342,50 +409,50 @@ namespace Exceptions {
 		void write(xlenreg_t value) { reg = (value & MASK);  }
 		xlenreg_t read() { return (reg & MASK); }
 
-		sc_dt::sc_uint_bitref SPF() { return reg.bit(14); }
-		sc_dt::sc_uint_bitref LPF() { return reg.bit(13); }
-		sc_dt::sc_uint_bitref IPF() { return reg.bit(12); }
-		//sc_dt::sc_uint_bitref ECM() { return reg.bit(11); }
-		sc_dt::sc_uint_bitref ECS() { return reg.bit(9); }
-		sc_dt::sc_uint_bitref ECU() { return reg.bit(8); }
-		sc_dt::sc_uint_bitref SAF() { return reg.bit(7); }
-		sc_dt::sc_uint_bitref SAM() { return reg.bit(6); }
-		sc_dt::sc_uint_bitref LAF() { return reg.bit(5); }
-		sc_dt::sc_uint_bitref LAM() { return reg.bit(4); }
-		sc_dt::sc_uint_bitref BP() { return reg.bit(3); }
-		sc_dt::sc_uint_bitref II() { return reg.bit(2); }
-		sc_dt::sc_uint_bitref IAF() { return reg.bit(1); }
-		sc_dt::sc_uint_bitref IAM() { return reg.bit(0); }
+		bitref_t SPF() { return reg.bit(14); }
+		bitref_t LPF() { return reg.bit(13); }
+		bitref_t IPF() { return reg.bit(12); }
+		//bitref_t ECM() { return reg.bit(11); }
+		bitref_t ECS() { return reg.bit(9); }
+		bitref_t ECU() { return reg.bit(8); }
+		bitref_t SAF() { return reg.bit(7); }
+		bitref_t SAM() { return reg.bit(6); }
+		bitref_t LAF() { return reg.bit(5); }
+		bitref_t LAM() { return reg.bit(4); }
+		bitref_t BP() { return reg.bit(3); }
+		bitref_t II() { return reg.bit(2); }
+		bitref_t IAF() { return reg.bit(1); }
+		bitref_t IAM() { return reg.bit(0); }
 	};
 };
 
 /* RISC-V instruction format */
 class Instruction : public Register {
 public:
-	sc_dt::sc_uint_subref opcode() { return reg.range(6, 0); }
-	sc_dt::sc_uint_subref rd() { return reg.range(11, 7); }
-	sc_dt::sc_uint_subref funct3() { return reg.range(14, 12); }
-	sc_dt::sc_uint_subref rs1() { return reg.range(19, 15); }
-	sc_dt::sc_uint_subref rs2() { return reg.range(24, 20); }
-	sc_dt::sc_uint_subref funct7() { return reg.range(31, 25); }
-	sc_dt::sc_uint_subref imm_11_0() { return reg.range(31, 20); }
-	sc_dt::sc_uint_subref imm_4_0() { return reg.range(11, 7); }
-	sc_dt::sc_uint_subref imm_11_5() { return reg.range(31, 25); }
-	sc_dt::sc_uint_bitref imm_11_B() { return reg.bit(7); }
-	sc_dt::sc_uint_subref imm_4_1() { return reg.range(11, 8); }
-	sc_dt::sc_uint_subref imm_10_5() { return reg.range(30, 25); }
-	sc_dt::sc_uint_bitref imm_12() { return reg.bit(31); }
-	sc_dt::sc_uint_subref imm_31_12() { return reg.range(31, 12); }
-	sc_dt::sc_uint_subref imm_19_12() { return reg.range(19, 12); }
-	sc_dt::sc_uint_bitref imm_11_J() { return reg.bit(20); }
-	sc_dt::sc_uint_subref imm_10_1() { return reg.range(30, 21); }
-	sc_dt::sc_uint_bitref imm_20() { return reg.bit(31); }
+	subref_t opcode() { return reg.range(6, 0); }
+	subref_t rd() { return reg.range(11, 7); }
+	subref_t funct3() { return reg.range(14, 12); }
+	subref_t rs1() { return reg.range(19, 15); }
+	subref_t rs2() { return reg.range(24, 20); }
+	subref_t funct7() { return reg.range(31, 25); }
+	subref_t imm_11_0() { return reg.range(31, 20); }
+	subref_t imm_4_0() { return reg.range(11, 7); }
+	subref_t imm_11_5() { return reg.range(31, 25); }
+	bitref_t imm_11_B() { return reg.bit(7); }
+	subref_t imm_4_1() { return reg.range(11, 8); }
+	subref_t imm_10_5() { return reg.range(30, 25); }
+	bitref_t imm_12() { return reg.bit(31); }
+	subref_t imm_31_12() { return reg.range(31, 12); }
+	subref_t imm_19_12() { return reg.range(19, 12); }
+	bitref_t imm_11_J() { return reg.bit(20); }
+	subref_t imm_10_1() { return reg.range(30, 21); }
+	bitref_t imm_20() { return reg.bit(31); }
 };
 
 class Address : public Register {
 public:
 	void next() { reg += 4; }
-	sc_dt::sc_uint_subref page_offset() { return reg.range(11, 0); }
+	subref_t page_offset() { return reg.range(11, 0); }
 };
 
 class Mtvec : public Register {
@@ -394,8 +461,8 @@ public:
 		DIRECT,
 		VECTORED
 	};
-	sc_dt::sc_uint_subref BASE() { return reg.range(31, 2); }
-	sc_dt::sc_uint_subref MODE() { return reg.range(1, 0); }
+	subref_t BASE() { return reg.range(31, 2); }
+	subref_t MODE() { return reg.range(1, 0); }
 };
 
 namespace Sv32 {
@@ -406,33 +473,33 @@ namespace Sv32 {
 	class VirtualAddress : public Address {
 	public:
 		VirtualAddress(Address addr) { reg = addr.read(); }
-		sc_dt::sc_uint_subref VPN(int level) { return level ? reg.range(31, 22) : reg.range(21, 12); }
+		subref_t VPN(int level) { return level ? reg.range(31, 22) : reg.range(21, 12); }
 	};
 
 	class PhysicalAddress : public Address {
 	private:
-		sc_uint<34> reg;
+		paddr_t reg;
 	public:
 		PhysicalAddress();
-		PhysicalAddress(sc_uint<34> pa) : reg(pa) {};
-		sc_dt::sc_uint_subref PPN(int level) { return level ? reg.range(33, 22) : reg.range(21, 12); }
-		sc_dt::sc_uint_subref PPN() { return reg.range(33, 12); }
+		PhysicalAddress(paddr_t pa) : reg(pa) {};
+		paddr_subref_t PPN(int level) { return level ? reg.range(33, 22) : reg.range(21, 12); }
+		paddr_subref_t PPN() { return reg.range(33, 12); }
 	};
 
 	class PageTableEntry : public Register {
 	public:
-		sc_dt::sc_uint_subref PPN(int level) { return level ? reg.range(31, 20) : reg.range(19, 10); }
-		sc_dt::sc_uint_subref PPN() { return reg.range(31, 10); }
-
-		//sc_dt::sc_uint_subref RSW() { return reg.range(9, 8); }
-		sc_dt::sc_uint_bitref D() { return reg.bit(7); }
-		sc_dt::sc_uint_bitref A() { return reg.bit(6); }
-		sc_dt::sc_uint_bitref G() { return reg.bit(5); }
-		sc_dt::sc_uint_bitref U() { return reg.bit(4); }
-		sc_dt::sc_uint_bitref X() { return reg.bit(3); }
-		sc_dt::sc_uint_bitref W() { return reg.bit(2); }
-		sc_dt::sc_uint_bitref R() { return reg.bit(1); }
-		sc_dt::sc_uint_bitref V() { return reg.bit(0); }
+		subref_t PPN(int level) { return level ? reg.range(31, 20) : reg.range(19, 10); }
+		subref_t PPN() { return reg.range(31, 10); }
+
+		//subref_t RSW() { return reg.range(9, 8); }
+		bitref_t D() { return reg.bit(7); }
+		bitref_t A() { return reg.bit(6); }
+		bitref_t G() { return reg.bit(5); }
+		bitref_t U() { return reg.bit(4); }
+		bitref_t X() { return reg.bit(3); }
+		bitref_t W() { return reg.bit(2); }
+		bitref_t R() { return reg.bit(1); }
+		bitref_t V() { return reg.bit(0); }
 	};
 };
 
@@ -442,9 +509,9 @@ public:
 		BARE,
 		Sv32
 	};
-	sc_dt::sc_uint_bitref MODE() { return reg.bit(31); }
-	sc_dt::sc_uint_subref ASID() { return reg.range(30, 22); }
-	sc_dt::sc_uint_subref PPN() { return reg.range(21, 0); }
+	bitref_t MODE() { return reg.bit(31); }
+	subref_t ASID() { return reg.range(30, 22); }
+	subref_t PPN() { return reg.range(21, 0); }
 };
 
 namespace Timings {
@@ -459,6 +526,23 @@ namespace Timings {
 	static const uint32_t FETCH = 1;
 };
 
+namespace Stats {
+	/* Instruction classes of the statistics counters */
+	enum CLASS : uint8_t {
+		LOGICAL,
+		BRANCH,
+		JUMP,
+		MOVE,
+		OTHER,
+		ARITH,
+		LOAD,
+		SHIFT,
+		NOP,
+		MULT_DIV,
+		COUNT
+	};
+};
+
 namespace CSR
 {
 	static const uint16_t RWA_MASK = 0x0C00;
@@ -510,5 +594,5 @@ public:
 		SATP
 	};
 
-	sc_dt::sc_uint_bitref MODE() { return reg.bit(0); }
+	bitref_t MODE() { return reg.bit(0); }
 };
\ No newline at end of file
@@ -18,9 +18,23 @@ SC_MODULE_EXPORT(RiscV);
 
 const uint8_t RiscV::PAGE_SHIFT = (unsigned char)(log2(PAGE_SIZE_BYTES));
 
+unsigned long int RiscV::* const RiscV::CLASS_COUNTERS[2][Stats::CLASS::COUNT] = {
+	{
+		&RiscV::logical_inst_kernel, &RiscV::branch_inst_kernel, &RiscV::jump_inst_kernel, &RiscV::move_inst_kernel,
+		&RiscV::other_inst_kernel, &RiscV::arith_inst_kernel, &RiscV::load_inst_kernel, &RiscV::shift_inst_kernel,
+		&RiscV::nop_inst_kernel, &RiscV::mult_div_inst_kernel
+	},
+	{
+		&RiscV::logical_inst_tasks, &RiscV::branch_inst_tasks, &RiscV::jump_inst_tasks, &RiscV::move_inst_tasks,
+		&RiscV::other_inst_tasks, &RiscV::arith_inst_tasks, &RiscV::load_inst_tasks, &RiscV::shift_inst_tasks,
+		&RiscV::nop_inst_tasks, &RiscV::mult_div_inst_tasks
+	}
+};
+
 RiscV::RiscV(sc_module_name name_, half_flit_t router_addr_) : 
-				sc_module(name_), router_addr(router_addr_),
-				mvendorid(0), marchid(0), mimpid(0), mhartid(0)
+				sc_module(name_), dmi_ram(nullptr), dmi_words(0), page(0), bus_dirty(false),
+				quantum(0), local_cycles(0), block_exec(false), in_block(false), tlb_sets(0), tlb_ways(0),
+				router_addr(router_addr_), mvendorid(0), marchid(0), mimpid(0), mhartid(0)
 {
 	pc_count				= 0;
 	logical_inst			= 0;
@@ -57,35 +71,167 @@ RiscV::RiscV(sc_module_name name_, half_flit_t router_addr_) :
 	shift_inst_tasks		= 0;	
 	nop_inst_tasks			= 0;	
 	mult_div_inst_tasks		= 0;
+	tlb_hits				= 0;
+	tlb_misses				= 0;
+
+	for(int u = 0; u < 2; u++)
+		for(int c = 0; c < Stats::CLASS::COUNT; c++)
+			inst_count[u][c] = 0;
+
+	for(uint32_t i = 0; i < DECODE_CACHE_SIZE; i++)
+		decode_cache[i].execute = nullptr;
+
+	for(uint32_t i = 0; i < BLOCK_CACHE_SIZE; i++)
+		block_cache[i].pc = 1;	// Never a valid PC
 
 	SC_THREAD(cpu);
 	sensitive << clk.pos();// << mem_pause.pos();
 	//sensitive << mem_pause.neg();
 }
 
+void RiscV::set_dmi(ram *ram_, uint32_t words_)
+{
+	dmi_ram = ram_;
+	dmi_words = words_;
+}
+
+void RiscV::set_quantum(uint32_t cycles_)
+{
+	quantum = cycles_;
+}
+
+void RiscV::set_block_exec(bool enable_)
+{
+	block_exec = enable_;
+}
+
+void RiscV::set_tlb(uint32_t entries_, uint32_t ways_)
+{
+	if(!entries_ || !ways_){
+		tlb_sets = tlb_ways = 0;
+		tlb.clear();
+		tlb_victim.clear();
+		return;
+	}
+
+	tlb_ways = ways_;
+	tlb_sets = entries_ / ways_;
+	if(!tlb_sets || (tlb_sets & (tlb_sets - 1))){
+		cout << "ERROR: TLB sets must be a power of two. TLB disabled" << endl;
+		tlb_sets = tlb_ways = 0;
+		return;
+	}
+
+	tlb.resize(tlb_sets * tlb_ways);
+	tlb_victim.assign(tlb_sets, 0);
+	tlb_flush();
+}
+
+void RiscV::tlb_flush()
+{
+	for(uint32_t i = 0; i < tlb.size(); i++)
+		tlb[i].valid = false;
+}
+
+void RiscV::update_stats()
+{
+	for(int u = 0; u < 2; u++)
+		for(int c = 0; c < Stats::CLASS::COUNT; c++)
+			this->*CLASS_COUNTERS[u][c] = inst_count[u][c];
+
+	global_inst_kernel	= logical_inst_kernel + branch_inst_kernel + jump_inst_kernel + move_inst_kernel + other_inst_kernel + arith_inst_kernel + load_inst_kernel + shift_inst_kernel + nop_inst_kernel + mult_div_inst_kernel;
+	global_inst_tasks	= logical_inst_tasks + branch_inst_tasks + jump_inst_tasks + move_inst_tasks + other_inst_tasks + arith_inst_tasks + load_inst_tasks + shift_inst_tasks + nop_inst_tasks + mult_div_inst_tasks;
+	logical_inst		= logical_inst_kernel + logical_inst_tasks;
+	branch_inst			= branch_inst_kernel + branch_inst_tasks;
+	jump_inst			= jump_inst_kernel + jump_inst_tasks;
+	move_inst			= move_inst_kernel + move_inst_tasks;
+	other_inst			= other_inst_kernel + other_inst_tasks;
+	arith_inst			= arith_inst_kernel + arith_inst_tasks;
+	load_inst			= load_inst_kernel + load_inst_tasks;
+	shift_inst			= shift_inst_kernel + shift_inst_tasks;			
+	nop_inst			= nop_inst_kernel + nop_inst_tasks;			
+	mult_div_inst		= mult_div_inst_kernel + mult_div_inst_tasks;
+	global_inst			= global_inst_kernel + global_inst_tasks;
+}
+
+void RiscV::end_of_simulation()
+{
+	if(!tlb_hits && !tlb_misses)	// Sv32 not in use
+		return;
+
+	FILE *fp = fopen("log_tlb.txt", "a+");
+	if(fp == NULL)
+		return;
+
+	fprintf(fp, "%d,%lu,%lu\n", (int)router_addr, tlb_hits, tlb_misses);
+	fclose(fp);
+}
+
+void RiscV::checkpoint(Checkpoint &ckp)
+{
+	Privilege::Level level = priv.get();
+
+	for(int i = 0; i < 32; i++)
+		ckp.io_reg(x[i]);
+	ckp.io_reg(pc);
+	ckp.io(level);
+	priv.set(level);
+
+	ckp.io_reg(mvendorid);
+	ckp.io_reg(marchid);
+	ckp.io_reg(mimpid);
+	ckp.io_reg(mhartid);
+	ckp.io_reg(mstatus);
+	ckp.io_reg(misa);
+	ckp.io_reg(medeleg);
+	ckp.io_reg(mideleg);
+	ckp.io_reg(mie);
+	ckp.io_reg(mtvec);
+	ckp.io_reg(mscratch);
+	ckp.io_reg(mepc);
+	ckp.io_reg(mcause);
+	ckp.io_reg(mtval);
+	ckp.io_reg(mip);
+	ckp.io_reg(stvec);
+	ckp.io_reg(sscratch);
+	ckp.io_reg(sepc);
+	ckp.io_reg(scause);
+	ckp.io_reg(stval);
+	ckp.io_reg(satp);
+	ckp.io_reg(mrar);
+
+	ckp.io(page);
+	ckp.io(bus_dirty);
+	ckp.io(pc_count);
+	ckp.io(inst_count);
+	ckp.io(tlb_hits);
+	ckp.io(tlb_misses);
+
+	if(!ckp.saving())
+		tlb_flush();
+}
+
+void RiscV::park()
+{
+	sync();
+	Checkpoint::parked()++;
+	while(Checkpoint::park())
+		wait();
+	Checkpoint::parked()--;
+}
+
 void RiscV::cpu()
 {
-	reset();
+	if(!Checkpoint::park())	// A restored CPU starts parked, without reset
+		reset();
 
 	while(true) {
+		if(Checkpoint::park())
+			park();
+
 		// Don't save PC on mem_pause: deprecated
 		// @todo Global inst CSR?
 
-		/* Stats */
-		global_inst_kernel	= logical_inst_kernel + branch_inst_kernel + jump_inst_kernel + move_inst_kernel + other_inst_kernel + arith_inst_kernel + load_inst_kernel + shift_inst_kernel + nop_inst_kernel + mult_div_inst_kernel;
-		global_inst_tasks	= logical_inst_tasks + branch_inst_tasks + jump_inst_tasks + move_inst_tasks + other_inst_tasks + arith_inst_tasks + load_inst_tasks + shift_inst_tasks + nop_inst_tasks + mult_div_inst_tasks;
-		logical_inst		= logical_inst_kernel + logical_inst_tasks;
-		branch_inst			= branch_inst_kernel + branch_inst_tasks;
-		jump_inst			= jump_inst_kernel + jump_inst_tasks;
-		move_inst			= move_inst_kernel + move_inst_tasks;
-		other_inst			= other_inst_kernel + other_inst_tasks;
-		arith_inst			= arith_inst_kernel + arith_inst_tasks;
-		load_inst			= load_inst_kernel + load_inst_tasks;
-		shift_inst			= shift_inst_kernel + shift_inst_tasks;			
-		nop_inst			= nop_inst_kernel + nop_inst_tasks;			
-		mult_div_inst		= mult_div_inst_kernel + mult_div_inst_tasks;
-		global_inst			= global_inst_kernel + global_inst_tasks;
-
 		x[0].write(0);
 
 		if(reset_in.read()){
@@ -94,9 +240,16 @@ void RiscV::cpu()
 		}
 
 		mip.MEI() = intr_in.read();
+		if(mip.MEI() && local_cycles){	// Take the interrupt in sync with the clock
+			sync();
+			mip.MEI() = intr_in.read();
+		}
 		if(handle_interrupts())	// If interrupt is handled, continues interrupt PC
 			continue;
 
+		if(block_exec && run_block())	// Whole basic block executed
+			continue;
+
 		if(fetch())	// If exception occurred, continues to exception PC
 			continue;
 
@@ -124,6 +277,7 @@ void RiscV::reset()
 	global_inst = 0;
 
 	mem_byte_we.write(0x0);
+	local_cycles = 0;
 	wait(Timings::RESET);
 }
 
@@ -191,6 +345,71 @@ bool RiscV::handle_interrupts()
 	return false;	// Interrupt not taken
 }
 
+bool RiscV::run_block()
+{
+	// Sv32 walks the page table on every fetch. Keep it in the regular path
+	if(priv.get() != Privilege::Level::MACHINE && mrar.MODE() == Mrar::MODES::SATP && satp.MODE() == Satp::MODES::Sv32)
+		return false;
+
+	Address phy_pc;
+	paging(pc, phy_pc, Exceptions::CODE::INSTRUCTION_PAGE_FAULT);	// Bare or offset never faults
+
+	uint32_t start = phy_pc.read();
+	uint32_t index;
+	if(!dmi_index(start, index))
+		return false;
+
+	Block &block = block_cache[(start >> 2) & (BLOCK_CACHE_SIZE - 1)];
+	bool record = (block.pc != start || block.code.empty());
+	if(record){
+		block.pc = start;
+		block.code.clear();
+	}
+
+	in_block = true;
+	for(uint32_t i = 0; ; i++){
+		uint32_t addr = start + 4*i;
+
+		x[0].write(0);
+		instr.write(mem_read(addr));
+		pc_count = addr;
+
+		if(!record && block.code[i].word != instr.read()){	// Code rewritten since recorded
+			block.code.resize(i);
+			record = true;
+		}
+
+		if(record){
+			if(decode())	// Illegal instruction. Block ends before it
+				break;
+			Decoded d = {(uint32_t)instr.read(), execute, iclass};
+			block.code.push_back(d);
+		} else {
+			execute = block.code[i].execute;
+			inst_count[priv.get() == Privilege::Level::USER][block.code[i].iclass]++;
+		}
+
+		if((this->*execute)())	// Branch, jump or exception
+			break;
+
+		pc.next();
+
+		if(record){
+			if(iclass == Stats::JUMP || iclass == Stats::BRANCH || iclass == Stats::OTHER ||
+				!((addr + 4) & (Sv32::PAGESIZE - 1)) || block.code.size() == BLOCK_MAX)
+				break;
+		} else if(i + 1 == block.code.size()){
+			break;
+		}
+	}
+	in_block = false;
+
+	if(!quantum)	// Charge the whole block at once
+		sync();
+
+	return true;
+}
+
 bool RiscV::fetch()
 {
 	// wait(Timings::FETCH);
@@ -210,22 +429,37 @@ bool RiscV::paging(Address src_addr, Address &dst_addr, Exceptions::CODE e_code)
 {
 	if(priv.get() == Privilege::Level::MACHINE ||	// M-Mode is bare mode
 		(satp.MODE() == Satp::MODES::BARE && mrar.MODE() == Mrar::MODES::SATP)){
-		current_page.write(0);
+		set_page(0);
 		dst_addr.write(src_addr.read());
 		return false;
 	} else if(mrar.MODE() == Mrar::MODES::OFFSET){		
 		if(priv.get() == Privilege::Level::SUPERVISOR){ // Kernel is page 0
 			// @todo Inform externally of current page ??
-			current_page.write(0);
+			set_page(0);
 			dst_addr.write(src_addr.read());
 			return false;
 		} else { // U-Mode with offset
-			current_page.write(mrar.read()>>PAGE_SHIFT);
+			set_page(mrar.read()>>PAGE_SHIFT);
 			dst_addr.write(src_addr.read() | mrar.read());
 			return false;
 		}
 	} else { // Sv32
 		Sv32::VirtualAddress va(src_addr);
+
+		TlbEntry *set = nullptr;
+		uint32_t vpn = va.read() / Sv32::PAGESIZE;
+		if(tlb_sets){
+			set = &tlb[(vpn & (tlb_sets - 1)) * tlb_ways];
+			for(uint32_t w = 0; w < tlb_ways; w++){
+				if(set[w].valid && set[w].vpn == vpn && pte_allowed(set[w].pte)){
+					tlb_hits++;
+					dst_addr.write(set[w].ppn * Sv32::PAGESIZE + va.page_offset());
+					return false;
+				}
+			}
+			tlb_misses++;	// Walks the table. Faults are not cached
+		}
+
 		Sv32::PhysicalAddress a(satp.PPN() * Sv32::PAGESIZE);
 		for(int i = Sv32::LEVELS - 1; i >= 0; i--){
 			Sv32::PhysicalAddress pte_addr(a.read() + va.VPN(i)*Sv32::PTESIZE);
@@ -237,9 +471,7 @@ bool RiscV::paging(Address src_addr, Address &dst_addr, Exceptions::CODE e_code)
 				return true;
 			} else if(pte.R() || pte.X()){
 				// Leaf PTE
-				if(pte.X() && 
-					((priv.get() == Privilege::Level::USER && pte.U()) || 
-					 (priv.get() == Privilege::Level::SUPERVISOR && !pte.U()))){
+				if(pte_allowed(pte)){
 					// Memory execute allowed
 					if(i && pte.PPN(0)){
 						// Misaligned superpage
@@ -256,6 +488,15 @@ bool RiscV::paging(Address src_addr, Address &dst_addr, Exceptions::CODE e_code)
 						}
 						pa.PPN(Sv32::LEVELS - 1) = pte.PPN(Sv32::LEVELS - 1);
 						dst_addr.write(pa.PPN()*Sv32::PAGESIZE + pa.page_offset());
+
+						if(set != nullptr){
+							uint32_t &victim = tlb_victim[vpn & (tlb_sets - 1)];
+							set[victim].valid = true;
+							set[victim].vpn = vpn;
+							set[victim].ppn = pa.PPN();
+							set[victim].pte = pte;
+							victim = (victim + 1) % tlb_ways;
+						}
 						return false;
 					}
 				} else {
@@ -274,9 +515,70 @@ bool RiscV::paging(Address src_addr, Address &dst_addr, Exceptions::CODE e_code)
 	}
 }
 
-xlenreg_t RiscV::mem_read(sc_uint<34> address)
+bool RiscV::pte_allowed(Sv32::PageTableEntry pte)
+{
+	return pte.X() && 
+			((priv.get() == Privilege::Level::USER && pte.U()) || 
+			 (priv.get() == Privilege::Level::SUPERVISOR && !pte.U()));
+}
+
+void RiscV::set_page(uint8_t page_)
+{
+	page = page_;
+	current_page.write(page);
+}
+
+bool RiscV::dmi_index(paddr_t address, uint32_t &index)
+{
+	if(dmi_ram == nullptr || address.range(30, 28) != 0)	// MMIO or repository
+		return false;
+
+	uint32_t addr = address.range(31, 0);
+	if(page && (addr >> PAGE_SHIFT)){
+		addr &= (0xF0000000 | (PAGE_SIZE_BYTES - 1));
+		addr |= page * PAGE_SIZE_BYTES;
+	}
+
+	index = addr >> 2;
+	return index < dmi_words;
+}
+
+void RiscV::consume(uint32_t cycles)
+{
+	if(!quantum && !in_block){
+		sync();	// Cycles run ahead before the quantum was disabled
+		wait(cycles);
+		return;
+	}
+
+	local_cycles += cycles;
+	if(quantum && local_cycles >= quantum)
+		sync();
+}
+
+void RiscV::sync()
+{
+	if(local_cycles){
+		wait(local_cycles);
+		local_cycles = 0;
+	}
+}
+
+xlenreg_t RiscV::mem_read(paddr_t address)
 {
-	mem_address.write(address);
+	uint32_t index;
+	if(dmi_index(address, index)){
+		if(bus_dirty){	// Don't leave a MMIO or repository address on the bus
+			mem_address.write((uint32_t)address);
+			bus_dirty = false;
+		}
+		consume(Timings::MEM_READ);
+		return dmi_ram->read_word(index);
+	}
+
+	sync();
+	mem_address.write((uint32_t)address);
+	bus_dirty = true;
 	wait(Timings::MEM_READ);
 	xlenreg_t ret = mem_data_r.read();
 	// xlenreg_t ret;
@@ -287,7 +589,7 @@ xlenreg_t RiscV::mem_read(sc_uint<34> address)
 	return ret;
 }
 
-void RiscV::mem_write(sc_uint<34> address, xlenreg_t value, uint8_t byte)
+void RiscV::mem_write(paddr_t address, xlenreg_t value, uint8_t byte)
 {
 	// xlenreg_t arg;
 	// arg.range(31, 24) = value.range(7, 0);
@@ -295,8 +597,26 @@ void RiscV::mem_write(sc_uint<34> address, xlenreg_t value, uint8_t byte)
 	// arg.range(15, 8) = value.range(23, 16);
 	// arg.range(7, 0) = value.range(31, 24);
 
-	mem_address.write(address);
-	mem_data_w.write(value);
+	uint32_t index;
+	if(dmi_index(address, index)){
+		if(bus_dirty){
+			mem_address.write((uint32_t)address);
+			bus_dirty = false;
+		}
+		uint32_t mask = 0;
+		for(int i = 0; i < 4; i++){
+			if(byte & (1 << i))
+				mask |= 0xFF << (i*8);
+		}
+		dmi_ram->write_word(index, (dmi_ram->read_word(index) & ~mask) | (value & mask));
+		consume(Timings::MEM_WRITE);
+		return;
+	}
+
+	sync();
+	mem_address.write((uint32_t)address);
+	bus_dirty = true;
+	mem_data_w.write((uint32_t)value);
 	mem_byte_we.write(byte);	// Enable write
 	wait(Timings::MEM_WRITE);
 	mem_byte_we.write(0);		// Disable write
@@ -367,6 +687,30 @@ void RiscV::handle_exceptions(Exceptions::CODE code)
 }
 
 bool RiscV::decode()
+{
+	// The cached decoding is valid while the word at this address is the same,
+	// which also covers code rewritten by stores or by the DMNI
+	Decoded &entry = decode_cache[(pc_count >> 2) & (DECODE_CACHE_SIZE - 1)];
+	uint32_t word = instr.read();
+
+	if(entry.execute == nullptr || entry.word != word){
+		if(decode_opcode())	// Illegal instructions are not cached
+			return true;
+
+		entry.word = word;
+		entry.execute = execute;
+		entry.iclass = iclass;
+	} else {
+		execute = entry.execute;
+		iclass = entry.iclass;
+	}
+
+	inst_count[priv.get() == Privilege::Level::USER][iclass]++;
+
+	return false;
+}
+
+bool RiscV::decode_opcode()
 {
 	// wait(Timings::DECODE);
 	// First level of decoding. Decode the opcode
@@ -376,28 +720,24 @@ bool RiscV::decode()
 		break;
 	case (uint32_t)Instructions::OPCODES::LUI:
 		execute = &RiscV::lui;
-		arith_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		arith_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::ARITH;
 		break;
 	case (uint32_t)Instructions::OPCODES::AUIPC:
 		execute = &RiscV::auipc;
-		arith_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		arith_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::ARITH;
 		break;
 	case (uint32_t)Instructions::OPCODES::OP:
 		return decode_op();
 		break;
 	case (uint32_t)Instructions::OPCODES::JAL:
 		execute = &RiscV::jal;
-		jump_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		jump_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::JUMP;
 		break;
 	case (uint32_t)Instructions::OPCODES::JALR:
 		switch(instr.funct3()){
 		case (uint32_t)Instructions::FUNCT3::JALR:
 			execute = &RiscV::jalr;
-			jump_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			jump_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::JUMP;
 			break;
 		default:
 			handle_exceptions(Exceptions::CODE::ILLEGAL_INSTRUCTION);
@@ -417,8 +757,7 @@ bool RiscV::decode()
 		switch(instr.funct3()){
 		case (uint32_t)Instructions::FUNCT3::FENCE:
 			execute = &RiscV::fence;
-			nop_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			nop_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::NOP;
 			break;
 		default:
 			handle_exceptions(Exceptions::CODE::ILLEGAL_INSTRUCTION);
@@ -441,40 +780,33 @@ bool RiscV::decode_op_imm()
 	switch(instr.funct3()){
 	case (uint32_t)Instructions::FUNCT3::ADDI:
 		execute = &RiscV::addi;
-		arith_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		arith_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::ARITH;
 		break;
 	case (uint32_t)Instructions::FUNCT3::SLTI:
 		execute = &RiscV::slti;
-		shift_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		shift_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::SHIFT;
 		break;
 	case (uint32_t)Instructions::FUNCT3::SLTIU:
 		execute = &RiscV::sltiu;
-		shift_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		shift_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::SHIFT;
 		break;
 	case (uint32_t)Instructions::FUNCT3::XORI:
 		execute = &RiscV::xori;
-		logical_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		logical_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::LOGICAL;
 		break;
 	case (uint32_t)Instructions::FUNCT3::ORI:
 		execute = &RiscV::ori;
-		logical_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		logical_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::LOGICAL;
 		break;
 	case (uint32_t)Instructions::FUNCT3::ANDI:
 		execute = &RiscV::andi;
-		logical_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		logical_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::LOGICAL;
 		break;
 	case (uint32_t)Instructions::FUNCT3::SLLI:
 		switch(instr.funct7()){
 		case (uint32_t)Instructions::FUNCT7::SLLI:
 			execute = &RiscV::slli;
-			shift_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			shift_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::SHIFT;
 			break;
 		default:		
 			handle_exceptions(Exceptions::CODE::ILLEGAL_INSTRUCTION);
@@ -485,13 +817,11 @@ bool RiscV::decode_op_imm()
 		switch(instr.funct7()){
 		case (uint32_t)Instructions::FUNCT7::SRAI:
 			execute = &RiscV::srai;
-			shift_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			shift_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::SHIFT;
 			break;
 		case (uint32_t)Instructions::FUNCT7::SRLI:
 			execute = &RiscV::srli;
-			shift_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			shift_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::SHIFT;
 			break;
 		default:
 			handle_exceptions(Exceptions::CODE::ILLEGAL_INSTRUCTION);
@@ -513,13 +843,11 @@ bool RiscV::decode_op()
 		switch(instr.funct3()){
 		case (uint32_t)Instructions::FUNCT3::SUB:
 			execute = &RiscV::sub;
-			arith_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			arith_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::ARITH;
 			break;
 		case (uint32_t)Instructions::FUNCT3::SRA:
 			execute = &RiscV::sra;
-			shift_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			shift_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::SHIFT;
 			break;
 		default:
 			handle_exceptions(Exceptions::CODE::ILLEGAL_INSTRUCTION);
@@ -530,43 +858,35 @@ bool RiscV::decode_op()
 		switch(instr.funct3()){
 		case (uint32_t)Instructions::FUNCT3::MUL:
 			execute = &RiscV::mul;
-			mult_div_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			mult_div_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::MULT_DIV;
 			break;
 		case (uint32_t)Instructions::FUNCT3::MULH:
 			execute = &RiscV::mulh;
-			mult_div_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			mult_div_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::MULT_DIV;
 			break;
 		case (uint32_t)Instructions::FUNCT3::MULHSU:
 			execute = &RiscV::mulhsu;
-			mult_div_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			mult_div_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::MULT_DIV;
 			break;
 		case (uint32_t)Instructions::FUNCT3::MULHU:
 			execute = &RiscV::mulhu;
-			mult_div_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			mult_div_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::MULT_DIV;
 			break;
 		case (uint32_t)Instructions::FUNCT3::DIV:
 			execute = &RiscV::div;
-			mult_div_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			mult_div_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::MULT_DIV;
 			break;
 		case (uint32_t)Instructions::FUNCT3::DIVU:
 			execute = &RiscV::divu;
-			mult_div_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			mult_div_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::MULT_DIV;
 			break;
 		case (uint32_t)Instructions::FUNCT3::REM:
 			execute = &RiscV::rem;
-			mult_div_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			mult_div_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::MULT_DIV;
 			break;
 		case (uint32_t)Instructions::FUNCT3::REMU:
 			execute = &RiscV::remu;
-			mult_div_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			mult_div_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::MULT_DIV;
 			break;
 		default:
 			handle_exceptions(Exceptions::CODE::ILLEGAL_INSTRUCTION);
@@ -580,43 +900,35 @@ bool RiscV::decode_op()
 		switch(instr.funct3()){
 		case (uint32_t)Instructions::FUNCT3::ADD:
 			execute = &RiscV::add;
-			arith_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			arith_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::ARITH;
 			break;
 		case (uint32_t)Instructions::FUNCT3::SLL:
 			execute = &RiscV::sll;
-			shift_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			shift_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::SHIFT;
 			break;
 		case (uint32_t)Instructions::FUNCT3::SLT:
 			execute = &RiscV::slt;
-			shift_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			shift_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::SHIFT;
 			break;
 		case (uint32_t)Instructions::FUNCT3::SLTU:
 			execute = &RiscV::sltu;
-			shift_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			shift_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::SHIFT;
 			break;
 		case (uint32_t)Instructions::FUNCT3::XOR:
 			execute = &RiscV::_xor;
-			logical_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			logical_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::LOGICAL;
 			break;
 		case (uint32_t)Instructions::FUNCT3::SRL:
 			execute = &RiscV::srl;
-			logical_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			logical_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::LOGICAL;
 			break;
 		case (uint32_t)Instructions::FUNCT3::OR:
 			execute = &RiscV::_or;
-			logical_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			logical_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::LOGICAL;
 			break;
 		case (uint32_t)Instructions::FUNCT3::AND:
 			execute = &RiscV::_and;
-			logical_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-			logical_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+			iclass = Stats::LOGICAL;
 			break;
 		default:
 			handle_exceptions(Exceptions::CODE::ILLEGAL_INSTRUCTION);
@@ -635,33 +947,27 @@ bool RiscV::decode_branch()
 	switch(instr.funct3()){
 	case (uint32_t)Instructions::FUNCT3::BEQ:
 		execute = &RiscV::beq;
-		branch_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		branch_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::BRANCH;
 		break;
 	case (uint32_t)Instructions::FUNCT3::BNE:
 		execute = &RiscV::bne;
-		branch_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		branch_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::BRANCH;
 		break;
 	case (uint32_t)Instructions::FUNCT3::BLT:
 		execute = &RiscV::blt;
-		branch_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		branch_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::BRANCH;
 		break;
 	case (uint32_t)Instructions::FUNCT3::BGE:
 		execute = &RiscV::bge;
-		branch_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		branch_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::BRANCH;
 		break;
 	case (uint32_t)Instructions::FUNCT3::BLTU:
 		execute = &RiscV::bltu;
-		branch_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		branch_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::BRANCH;
 		break;
 	case (uint32_t)Instructions::FUNCT3::BGEU:
 		execute = &RiscV::bgeu;
-		branch_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		branch_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::BRANCH;
 		break;
 	default:
 		handle_exceptions(Exceptions::CODE::ILLEGAL_INSTRUCTION);
@@ -675,28 +981,23 @@ bool RiscV::decode_load()
 	switch(instr.funct3()){
 	case (uint32_t)Instructions::FUNCT3::LB:
 		execute = &RiscV::lb;
-		load_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		load_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::LOAD;
 		break;
 	case (uint32_t)Instructions::FUNCT3::LH:
 		execute = &RiscV::lh;
-		load_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		load_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::LOAD;
 		break;
 	case (uint32_t)Instructions::FUNCT3::LW:
 		execute = &RiscV::lw;
-		load_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		load_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::LOAD;
 		break;
 	case (uint32_t)Instructions::FUNCT3::LBU:
 		execute = &RiscV::lbu;
-		load_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		load_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::LOAD;
 		break;
 	case (uint32_t)Instructions::FUNCT3::LHU:
 		execute = &RiscV::lhu;
-		load_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		load_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::LOAD;
 		break;
 	default:
 		handle_exceptions(Exceptions::CODE::ILLEGAL_INSTRUCTION);
@@ -710,18 +1011,15 @@ bool RiscV::decode_store()
 	switch(instr.funct3()){
 	case (uint32_t)Instructions::FUNCT3::SB:
 		execute = &RiscV::sb;
-		load_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		load_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::LOAD;
 		break;
 	case (uint32_t)Instructions::FUNCT3::SH:
 		execute = &RiscV::sh;
-		load_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		load_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::LOAD;
 		break;
 	case (uint32_t)Instructions::FUNCT3::SW:
 		execute = &RiscV::sw;
-		load_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		load_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::LOAD;
 		break;
 	default:
 		handle_exceptions(Exceptions::CODE::ILLEGAL_INSTRUCTION);
@@ -740,13 +1038,11 @@ bool RiscV::decode_system()
 				switch(instr.rs2()){
 				case (uint32_t)Instructions::RS2::ECALL:
 					execute = &RiscV::ecall;
-					other_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-					other_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+					iclass = Stats::OTHER;
 					break;
 				case (uint32_t)Instructions::RS2::EBREAK:
 					execute = &RiscV::ebreak;
-					other_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-					other_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+					iclass = Stats::OTHER;
 					break;
 				default:
 					handle_exceptions(Exceptions::CODE::ILLEGAL_INSTRUCTION);
@@ -762,13 +1058,11 @@ bool RiscV::decode_system()
 				switch(instr.rs2()){
 				case (uint32_t)Instructions::RS2::RET:
 					execute = &RiscV::sret;
-					other_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-					other_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+					iclass = Stats::OTHER;
 					break;
 				case (uint32_t)Instructions::RS2::WFI:
 					execute = &RiscV::wfi;
-					other_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-					other_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+					iclass = Stats::OTHER;
 					break;
 				default:
 					handle_exceptions(Exceptions::CODE::ILLEGAL_INSTRUCTION);
@@ -782,8 +1076,7 @@ bool RiscV::decode_system()
 		case (uint32_t)Instructions::FUNCT7::MRET:
 			if(!(instr.rs1() || instr.rd()) && instr.rs2() == (uint32_t)Instructions::RS2::RET){
 				execute = &RiscV::mret;
-				other_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-				other_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+				iclass = Stats::OTHER;
 			} else {
 				handle_exceptions(Exceptions::CODE::ILLEGAL_INSTRUCTION);
 				return true;
@@ -792,8 +1085,7 @@ bool RiscV::decode_system()
 		case (uint32_t)Instructions::FUNCT7::SFENCE_VMA:
 			if(!instr.rd()){
 				execute = &RiscV::sfence_vma;
-				other_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-				other_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+				iclass = Stats::OTHER;
 			} else {
 				handle_exceptions(Exceptions::CODE::ILLEGAL_INSTRUCTION);
 				return true;
@@ -806,33 +1098,27 @@ bool RiscV::decode_system()
 		break;
 	case (uint32_t)Instructions::FUNCT3::CSRRW:
 		execute = &RiscV::csrrw;
-		other_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		other_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::OTHER;
 		break;
 	case (uint32_t)Instructions::FUNCT3::CSRRS:
 		execute = &RiscV::csrrs;
-		other_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		other_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::OTHER;
 		break;
 	case (uint32_t)Instructions::FUNCT3::CSRRC:
 		execute = &RiscV::csrrc;
-		other_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		other_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::OTHER;
 		break;
 	case (uint32_t)Instructions::FUNCT3::CSRRWI:
 		execute = &RiscV::csrrwi;
-		other_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		other_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::OTHER;
 		break;
 	case (uint32_t)Instructions::FUNCT3::CSRRSI:
 		execute = &RiscV::csrrsi;
-		other_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		other_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::OTHER;
 		break;
 	case (uint32_t)Instructions::FUNCT3::CSRRCI:
 		execute = &RiscV::csrrci;
-		other_inst_kernel += (int)(priv.get() != Privilege::Level::USER);
-		other_inst_tasks += (int)(priv.get() == Privilege::Level::USER);
+		iclass = Stats::OTHER;
 		break;
 	default:
 		handle_exceptions(Exceptions::CODE::ILLEGAL_INSTRUCTION);
@@ -843,7 +1129,7 @@ bool RiscV::decode_system()
 
 bool RiscV::lui()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	x[instr.rd()].range(31,12) = instr.imm_31_12();
 	x[instr.rd()].range(11,0) = 0;
 	return false;
@@ -851,7 +1137,7 @@ bool RiscV::lui()
 
 bool RiscV::auipc()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	Register r;
 	r.range(31,12) = instr.imm_31_12();
 	r.range(11,0) = 0;
@@ -862,7 +1148,7 @@ bool RiscV::auipc()
 
 bool RiscV::jal()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	// Sign-extend offset
 	Register r;
@@ -889,7 +1175,7 @@ bool RiscV::jal()
 
 bool RiscV::jalr()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	// Sign-extend offset
 	Register r;
@@ -912,7 +1198,7 @@ bool RiscV::jalr()
 
 bool RiscV::beq()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	if(x[instr.rs1()].read() == x[instr.rs2()].read()){ // Taken
 		// Sign-extend offset
 		Register r;
@@ -935,7 +1221,7 @@ bool RiscV::beq()
 
 bool RiscV::bne()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	if(x[instr.rs1()].read() != x[instr.rs2()].read()){ // Taken
 		// Sign-extend offset
 		Register r;
@@ -958,7 +1244,7 @@ bool RiscV::bne()
 
 bool RiscV::blt()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	if((int)x[instr.rs1()].read() < (int)x[instr.rs2()].read()){ // Taken
 		// Sign-extend offset
 		Register r;
@@ -981,7 +1267,7 @@ bool RiscV::blt()
 
 bool RiscV::bge()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	if((int)x[instr.rs1()].read() >= (int)x[instr.rs2()].read()){ // Taken
 		// Sign-extend offset
 		Register r;
@@ -1004,7 +1290,7 @@ bool RiscV::bge()
 
 bool RiscV::bltu()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	if((unsigned int)x[instr.rs1()].read() < (unsigned int)x[instr.rs2()].read()){ // Taken
 		// Sign-extend offset
 		Register r;
@@ -1027,7 +1313,7 @@ bool RiscV::bltu()
 
 bool RiscV::bgeu()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	if((unsigned int)x[instr.rs1()].read() >= (unsigned int)x[instr.rs2()].read()){ // Taken
 		// Sign-extend offset
 		Register r;
@@ -1050,7 +1336,7 @@ bool RiscV::bgeu()
 
 bool RiscV::lb()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	// Sign-extend offset
 	Register r;
 	r.range(31,12) = (int)instr.bit(31) * -1;
@@ -1086,7 +1372,7 @@ bool RiscV::lb()
 
 bool RiscV::lh()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	// Sign-extend offset
 	Register r;
 	r.range(31,12) = (int)instr.bit(31) * -1;
@@ -1122,7 +1408,7 @@ bool RiscV::lh()
 
 bool RiscV::lw()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	// Sign-extend offset
 	Register r;
 	r.range(31,12) = (int)instr.bit(31) * -1;
@@ -1152,7 +1438,7 @@ bool RiscV::lw()
 
 bool RiscV::lbu()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	// Sign-extend offset
 	Register r;
 	r.range(31,12) = (int)instr.bit(31) * -1;
@@ -1188,7 +1474,7 @@ bool RiscV::lbu()
 
 bool RiscV::lhu()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	// Sign-extend offset
 	Register r;
 	r.range(31,12) = (int)instr.bit(31) * -1;
@@ -1224,7 +1510,7 @@ bool RiscV::lhu()
 
 bool RiscV::sb()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	// Sign-extend offset
 	Register r;
@@ -1267,7 +1553,7 @@ bool RiscV::sb()
 
 bool RiscV::sh()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	// Sign-extend offset
 	Register r;
@@ -1308,7 +1594,7 @@ bool RiscV::sh()
 
 bool RiscV::sw()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	// Sign-extend offset
 	Register r;
@@ -1341,7 +1627,7 @@ bool RiscV::sw()
 
 bool RiscV::addi()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	// Sign-extend immediate
 	Register r;
 	r.range(31,12) = (int)instr.bit(31) * -1;
@@ -1354,7 +1640,7 @@ bool RiscV::addi()
 
 bool RiscV::slti()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	// Sign-extend immediate
 	Register r;
 	r.range(31,12) = (int)instr.bit(31) * -1;
@@ -1367,7 +1653,7 @@ bool RiscV::slti()
 
 bool RiscV::sltiu()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	// Sign-extend immediate
 	Register r;
 	r.range(31,12) = (int)instr.bit(31) * -1;
@@ -1380,7 +1666,7 @@ bool RiscV::sltiu()
 
 bool RiscV::xori()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	// Sign-extend immediate
 	Register r;
 	r.range(31,12) = (int)instr.bit(31) * -1;
@@ -1393,7 +1679,7 @@ bool RiscV::xori()
 
 bool RiscV::ori()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	// Sign-extend immediate
 	Register r;
 	r.range(31,12) = (int)instr.bit(31) * -1;
@@ -1406,7 +1692,7 @@ bool RiscV::ori()
 
 bool RiscV::andi()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	// Sign-extend immediate
 	Register r;
 	r.range(31,12) = (int)instr.bit(31) * -1;
@@ -1419,7 +1705,7 @@ bool RiscV::andi()
 
 bool RiscV::slli()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	// rs2 is imm[4:0] for shift
 	x[instr.rd()].write(x[instr.rs1()].read() << instr.rs2());
 
@@ -1428,7 +1714,7 @@ bool RiscV::slli()
 
 bool RiscV::srli()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 	// rs2 is imm[4:0] for shift
 	x[instr.rd()].write(x[instr.rs1()].read() >> instr.rs2());
 
@@ -1437,7 +1723,7 @@ bool RiscV::srli()
 
 bool RiscV::srai()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	Register r;
 	r.write(x[instr.rs1()].read());
@@ -1455,7 +1741,7 @@ bool RiscV::srai()
 
 bool RiscV::add()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	x[instr.rd()].write(x[instr.rs1()].read() + x[instr.rs2()].read());
 
@@ -1464,7 +1750,7 @@ bool RiscV::add()
 
 bool RiscV::sub()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	x[instr.rd()].write(x[instr.rs1()].read() - x[instr.rs2()].read());
 
@@ -1473,7 +1759,7 @@ bool RiscV::sub()
 
 bool RiscV::sll()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	x[instr.rd()].write(x[instr.rs1()].read() << x[instr.rs2()].range(4, 0));
 
@@ -1482,7 +1768,7 @@ bool RiscV::sll()
 
 bool RiscV::slt()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	x[instr.rd()].write(((int)x[instr.rs1()].read() < (int)x[instr.rs2()].read()));
 
@@ -1491,7 +1777,7 @@ bool RiscV::slt()
 
 bool RiscV::sltu()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	x[instr.rd()].write(((unsigned int)x[instr.rs1()].read() < (unsigned int)x[instr.rs2()].read()));
 
@@ -1500,7 +1786,7 @@ bool RiscV::sltu()
 
 bool RiscV::_xor()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	x[instr.rd()].write(x[instr.rs1()].read() ^ x[instr.rs2()].read());
 
@@ -1509,7 +1795,7 @@ bool RiscV::_xor()
 
 bool RiscV::srl()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	x[instr.rd()].write(x[instr.rs1()].read() >> x[instr.rs2()].range(4,0));
 
@@ -1518,7 +1804,7 @@ bool RiscV::srl()
 
 bool RiscV::sra()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	Register r;
 	r.write(x[instr.rs1()].read());
@@ -1535,7 +1821,7 @@ bool RiscV::sra()
 
 bool RiscV::_or()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	x[instr.rd()].write(x[instr.rs1()].read() | x[instr.rs2()].read());
 
@@ -1544,7 +1830,7 @@ bool RiscV::_or()
 
 bool RiscV::_and()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	x[instr.rd()].write(x[instr.rs1()].read() & x[instr.rs2()].read());
 
@@ -1553,14 +1839,14 @@ bool RiscV::_and()
 
 bool RiscV::fence()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	return false;
 }
 
 bool RiscV::ecall()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	switch(priv.get()){
 	case Privilege::Level::MACHINE:
@@ -1579,14 +1865,14 @@ bool RiscV::ecall()
 
 bool RiscV::ebreak()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	return false;
 }
 
 bool RiscV::mul()
 {
-	wait(Timings::MUL);
+	consume(Timings::MUL);
 
 	x[instr.rd()].write((uint32_t)x[instr.rs1()].read() * (uint32_t)x[instr.rs2()].read());
 
@@ -1595,7 +1881,7 @@ bool RiscV::mul()
 
 bool RiscV::mulh()
 {
-	wait(Timings::MUL);
+	consume(Timings::MUL);
 
 	uint64_t res = (int64_t)x[instr.rs1()].read() * (int64_t)x[instr.rs2()].read();
 	uint32_t high = res >> 32;
@@ -1607,7 +1893,7 @@ bool RiscV::mulh()
 
 bool RiscV::mulhsu()
 {
-	wait(Timings::MUL);
+	consume(Timings::MUL);
 
 	uint64_t res = (int64_t)x[instr.rs1()].read() * (uint64_t)x[instr.rs2()].read();
 	uint32_t high = res >> 32;
@@ -1619,7 +1905,7 @@ bool RiscV::mulhsu()
 
 bool RiscV::mulhu()
 {
-	wait(Timings::MUL);
+	consume(Timings::MUL);
 
 	uint64_t res = (uint64_t)x[instr.rs1()].read() * (uint64_t)x[instr.rs2()].read();
 	uint32_t high = res >> 32;
@@ -1631,7 +1917,7 @@ bool RiscV::mulhu()
 
 bool RiscV::div()
 {
-	wait(Timings::DIV);
+	consume(Timings::DIV);
 
 	if(!x[instr.rs1()].read()){ // 0 divided by anything is 0
 		x[instr.rd()].write(0);
@@ -1648,7 +1934,7 @@ bool RiscV::div()
 
 bool RiscV::divu()
 {
-	wait(Timings::DIV);
+	consume(Timings::DIV);
 
 	if(!x[instr.rs1()].read()){ // 0 divided by anything is 0
 		x[instr.rd()].write(0);
@@ -1663,7 +1949,7 @@ bool RiscV::divu()
 
 bool RiscV::rem()
 {
-	wait(Timings::DIV);
+	consume(Timings::DIV);
 
 	if(!x[instr.rs1()].read()){ // 0 divided by anything is 0
 		x[instr.rd()].write(0);
@@ -1680,7 +1966,7 @@ bool RiscV::rem()
 
 bool RiscV::remu()
 {
-	wait(Timings::DIV);
+	consume(Timings::DIV);
 
 	if(!x[instr.rs1()].read()){ // 0 divided by anything is 0
 		x[instr.rd()].write(0);
@@ -1695,7 +1981,7 @@ bool RiscV::remu()
 
 bool RiscV::csrrw()
 {
-	wait(Timings::CSR);
+	consume(Timings::CSR);
 
 	Register *csr = nullptr;
 	uint32_t wmand = -1;
@@ -1723,7 +2009,7 @@ bool RiscV::csrrw()
 
 bool RiscV::csrrs()
 {
-	wait(Timings::CSR);
+	consume(Timings::CSR);
 
 	Register *csr = nullptr;
 	uint32_t wmand = -1;
@@ -1750,7 +2036,7 @@ bool RiscV::csrrs()
 
 bool RiscV::csrrc()
 {
-	wait(Timings::CSR);
+	consume(Timings::CSR);
 
 	Register *csr = nullptr;
 	uint32_t wmand = -1;
@@ -1777,7 +2063,7 @@ bool RiscV::csrrc()
 
 bool RiscV::csrrwi()
 {
-	wait(Timings::CSR);
+	consume(Timings::CSR);
 
 	Register *csr = nullptr;
 	uint32_t wmand = -1;
@@ -1800,7 +2086,7 @@ bool RiscV::csrrwi()
 
 bool RiscV::csrrsi()
 {
-	wait(Timings::CSR);
+	consume(Timings::CSR);
 
 	Register *csr = nullptr;
 	uint32_t wmand = -1;
@@ -1823,7 +2109,7 @@ bool RiscV::csrrsi()
 
 bool RiscV::csrrci()
 {
-	wait(Timings::CSR);
+	consume(Timings::CSR);
 
 	Register *csr = nullptr;
 	uint32_t wmand = -1;
@@ -1846,7 +2132,7 @@ bool RiscV::csrrci()
 
 bool RiscV::sret()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	// Can only be called in M and S-Mode and if SRET trap is disabled
 	if(priv.get() == Privilege::Level::USER || mstatus.TSR()){
@@ -1867,7 +2153,7 @@ bool RiscV::sret()
 
 bool RiscV::mret()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	// Can only be called in M-Mode
 	if(priv.get() != Privilege::Level::MACHINE){
@@ -1888,7 +2174,7 @@ bool RiscV::mret()
 
 bool RiscV::wfi()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	// Not available in U-Mode or if timeout wait in S-Mode
 	if(priv.get() == Privilege::Level::USER || (mstatus.TW() && priv.get() == Privilege::Level::SUPERVISOR)){
@@ -1903,14 +2189,14 @@ bool RiscV::wfi()
 
 bool RiscV::sfence_vma()
 {
-	wait(Timings::LOGICAL);
+	consume(Timings::LOGICAL);
 
 	if(priv.get() == Privilege::Level::USER){
 		handle_exceptions(Exceptions::CODE::ILLEGAL_INSTRUCTION);
 		return true;
 	}
 
-	// NOP
+	tlb_flush();
 
 	return false;
 }
@@ -2034,6 +2320,8 @@ bool RiscV::csr_helper(uint16_t addr, bool rw, Register* &csr, uint32_t &wmask_a
 		break;
 	case CSR::Address::SATP:
 		csr = &satp;
+		if(rw)	// New root or ASID
+			tlb_flush();
 		break;
 	case CSR::Address::MRAR:
 		csr = &mrar;
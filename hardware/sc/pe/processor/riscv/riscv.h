@@ -13,13 +13,24 @@
 
 #include <systemc.h>
 #include <stdint.h>
+#include <vector>
 #include "../../../standards.h"
+#include "../../memory/ram.h"
 
 /* Length of a flit */
 static const int FLIT_SIZE = 32;
 static const int HALF_FLIT = FLIT_SIZE/2;
 typedef sc_uint<HALF_FLIT> half_flit_t;
 
+/* Entries of the decoded instruction cache. Must be a power of two */
+static const uint32_t DECODE_CACHE_SIZE = 4096;
+
+/* Entries of the basic block cache. Must be a power of two */
+static const uint32_t BLOCK_CACHE_SIZE = 1024;
+
+/* Maximum number of instructions in a basic block */
+static const uint32_t BLOCK_MAX = 64;
+
 namespace vectors {
 	const uint32_t RESET = 0;
 };
@@ -84,6 +95,9 @@ public:
 	unsigned long int shift_inst_tasks;
 	unsigned long int nop_inst_tasks;
 	unsigned long int mult_div_inst_tasks;
+	/* Sv32 TLB lookups */
+	unsigned long int tlb_hits;
+	unsigned long int tlb_misses;
 
 	/**
 	 * @brief The loop of the RISC-V CPU.
@@ -100,9 +114,127 @@ public:
 	 */
 	RiscV(sc_module_name name_, half_flit_t router_addr_ = 0);
 
+	/**
+	 * @brief Enables the Direct Memory Interface (DMI) to the PE RAM.
+	 * 
+	 * @detail RAM accesses bypass the memory bus signals, keeping the same
+	 * 		   timing. MMIO and repository accesses still use the bus.
+	 * 
+	 * @param *ram_		Pointer to the PE RAM.
+	 * @param words_	Number of words in the RAM.
+	 */
+	void set_dmi(ram *ram_, uint32_t words_);
+
+	/**
+	 * @brief Sets the temporal decoupling quantum.
+	 * 
+	 * @detail The CPU runs ahead of the clock up to the quantum, syncing
+	 * 		   on bus accesses and pending interrupts.
+	 * 
+	 * @param cycles_ Quantum in clock cycles. 0 disables decoupling.
+	 */
+	void set_quantum(uint32_t cycles_);
+
+	/**
+	 * @brief Enables the basic block execution mode.
+	 * 
+	 * @detail Basic blocks fetched from the DMI RAM are executed as a
+	 * 		   whole, charging their cycles in a single wait. Needs DMI.
+	 * 
+	 * @param enable_ True to execute by basic blocks.
+	 */
+	void set_block_exec(bool enable_);
+
+	/**
+	 * @brief Sizes the Sv32 TLB.
+	 * 
+	 * @detail The TLB caches leaf translations and is flushed on satp
+	 * 		   writes and sfence.vma.
+	 * 
+	 * @param entries_	Number of entries. 0 disables the TLB.
+	 * @param ways_		Associativity. entries_/ways_ must be a power of two.
+	 */
+	void set_tlb(uint32_t entries_, uint32_t ways_);
+
+	/**
+	 * @brief Updates the statistics counters from the instruction counts.
+	 * 
+	 * @detail Must be called before reading the *_inst* counters.
+	 */
+	void update_stats();
+
+	/**
+	 * @brief Logs the TLB statistics to log_tlb.txt.
+	 */
+	void end_of_simulation();
+
+	/**
+	 * @brief Saves or loads the CPU state.
+	 * 
+	 * @detail The CPU must be parked. Decoded instructions, blocks and TLB
+	 * 		   entries are not saved and are rebuilt after a load.
+	 * 
+	 * @param &ckp The checkpoint file.
+	 */
+	void checkpoint(Checkpoint &ckp);
+
 private:
 	static const uint8_t PAGE_SHIFT;
 
+	/* DMI pointer to the PE RAM. nullptr when DMI is disabled */
+	ram *dmi_ram;
+	uint32_t dmi_words;
+
+	/* Last page written to current_page */
+	uint8_t page;
+
+	/* Bus address holds a non-RAM access that DMI must clear */
+	bool bus_dirty;
+
+	/* Temporal decoupling quantum and cycles run ahead of the clock */
+	uint32_t quantum;
+	uint32_t local_cycles;
+
+	/* Executed instructions of each class. Indexed by [is user][class] */
+	unsigned long int inst_count[2][Stats::CLASS::COUNT];
+
+	/* Statistics counter of each instruction class. Indexed by [is user][class] */
+	static unsigned long int RiscV::* const CLASS_COUNTERS[2][Stats::CLASS::COUNT];
+
+	/* Decoded instruction cache, indexed by the physical PC */
+	struct Decoded {
+		uint32_t word;
+		bool (RiscV::*execute)();
+		Stats::CLASS iclass;
+	};
+	Decoded decode_cache[DECODE_CACHE_SIZE];
+
+	/* Class of the decoded instruction */
+	Stats::CLASS iclass;
+
+	/* Basic block cache, indexed by the physical PC of the block start */
+	struct Block {
+		uint32_t pc;
+		std::vector<Decoded> code;
+	};
+	Block block_cache[BLOCK_CACHE_SIZE];
+
+	/* Basic block execution enabled and running a block */
+	bool block_exec;
+	bool in_block;
+
+	/* Sv32 TLB entry. Caches the leaf PTE of a 4 KB virtual page */
+	struct TlbEntry {
+		bool valid;
+		uint32_t vpn;
+		uint32_t ppn;
+		Sv32::PageTableEntry pte;
+	};
+	std::vector<TlbEntry> tlb;
+	uint32_t tlb_sets;
+	uint32_t tlb_ways;
+	std::vector<uint32_t> tlb_victim;	// Next way replaced in each set
+
 	/* PE router address. Used by the simulator */
 	half_flit_t router_addr;
 
@@ -205,6 +337,11 @@ private:
 	 */
 	void reset();
 
+	/**
+	 * @brief Stops between two instructions while a checkpoint is taken.
+	 */
+	void park();
+
 	/**
 	 * @brief Handle pending interrupts.
 	 * 
@@ -214,6 +351,17 @@ private:
 	 */
 	bool handle_interrupts();
 
+	/**
+	 * @brief Executes the basic block at the PC from the DMI RAM.
+	 * 
+	 * @detail The block is recorded while it runs for the first time and
+	 * 		   replayed from the block cache afterwards. It ends on a jump,
+	 * 		   branch, system instruction or at a 4 KB boundary.
+	 * 
+	 * @return False if the block can't run and the PC must be executed normally.
+	 */
+	bool run_block();
+
 	/**
 	 * @brief Fetches an instruction.
 	 * 
@@ -232,6 +380,20 @@ private:
 	 */
 	bool paging(Address src_addr, Address &dst_addr, Exceptions::CODE e_code);
 
+	/**
+	 * @brief Checks if the current privilege can access a leaf PTE.
+	 * 
+	 * @param pte The leaf PTE.
+	 * 
+	 * @return True if the access is allowed
+	 */
+	bool pte_allowed(Sv32::PageTableEntry pte);
+
+	/**
+	 * @brief Invalidates all TLB entries.
+	 */
+	void tlb_flush();
+
 	/**
 	 * @brief Reads XLEN from memory.
 	 * 
@@ -239,7 +401,7 @@ private:
 	 * 
 	 * @return XLEN bits from memory address.
 	 */
-	xlenreg_t mem_read(sc_uint<34> address);
+	xlenreg_t mem_read(paddr_t address);
 
 	/**
 	 * @brief Writes XLEN to memory.
@@ -248,7 +410,38 @@ private:
 	 * @param value		The value to be written
 	 * @param byte		The write enable byte to write.
 	 */
-	void mem_write(sc_uint<34> address, xlenreg_t value, uint8_t byte);
+	void mem_write(paddr_t address, xlenreg_t value, uint8_t byte);
+
+	/**
+	 * @brief Translates a physical address to a RAM word through DMI.
+	 * 
+	 * @detail Applies the same page relocation done by the PE bus logic.
+	 * 
+	 * @param address	The physical address.
+	 * @param &index	The RAM word index.
+	 * 
+	 * @return True if the address can be accessed through DMI.
+	 */
+	bool dmi_index(paddr_t address, uint32_t &index);
+
+	/**
+	 * @brief Writes to the current_page port, keeping a local copy.
+	 * 
+	 * @param page_ The page of the current access.
+	 */
+	void set_page(uint8_t page_);
+
+	/**
+	 * @brief Consumes clock cycles, running ahead of the clock if decoupled.
+	 * 
+	 * @param cycles Number of clock cycles.
+	 */
+	void consume(uint32_t cycles);
+
+	/**
+	 * @brief Waits the cycles run ahead of the clock.
+	 */
+	void sync();
 
 	/**
 	 * @brief Handles synchronous exceptions
@@ -256,12 +449,19 @@ private:
 	void handle_exceptions(Exceptions::CODE code);
 
 	/**
-	 * @brief Decodes and executes the fetched instruction.
+	 * @brief Decodes the fetched instruction through the decoded instruction cache.
 	 * 
 	 * @return True if exception occurred
 	 */
 	bool decode();
 
+	/**
+	 * @brief Decodes the fetched instruction, setting execute and iclass.
+	 * 
+	 * @return True if exception occurred
+	 */
+	bool decode_opcode();
+
 	/**
 	 * @brief Decodes the OP-IMM opcode.
 	 * 
@@ -21,21 +21,21 @@
 // DO CONTRARIO
 //   TEM_ESPACO_NA_FILA = FALSE
 void fila::in_proc_FSM(){
-	sc_uint<4> local_first, local_last;
+	unsigned int local_occupancy;
 	
-	local_first = first.read();
-	local_last = last.read();
+	local_occupancy = occupancy();
 	
 	if(reset_n.read() == false){
 		tem_espaco_na_fila.write(true);
 			credit_o.write(true);
 	}
 	else{
-		if (((local_first==0) && (local_last==(BUFFER_TAM-2))) || (local_first==(local_last+2)) || (local_first==(local_last+1))){
+		// A FILA FICA CHEIA DOIS FLITS ANTES DO FIM E VOLTA A ACEITAR COM UM QUARTO DA OCUPACAO
+		if (local_occupancy >= depth - 2){
 			tem_espaco_na_fila.write(false);
 			credit_o.write(false);
 		}
-		else if(((local_last - local_first) == 2) || ((local_first - local_last) == BUFFER_TAM-2)){
+		else if(local_occupancy <= depth / 4){
 			tem_espaco_na_fila.write(true);
 			credit_o.write(true);
 		}
@@ -50,13 +50,13 @@ void fila::in_proc_FSM(){
 void fila::in_proc_updPtr(){
 	if(reset_n.read()==false){
 		last.write(0);
-		for(int i=0;i<BUFFER_TAM;i++) buffer_in[i]=0;
+		for(unsigned int i=0;i<depth;i++) buffer_in[i]=0;
 	}
 	else{
 		if((tem_espaco_na_fila.read()==true) && (rx.read()==true)){
 			buffer_in[last.read()] = data_in.read();
 			//incrementa o last
-			if(last.read()==(BUFFER_TAM - 1))
+			if(last.read()==(depth - 1))
 				last.write(0);
 			else
 				last.write((last.read() + 1));
@@ -69,6 +69,7 @@ void fila::out_proc_data()
 {
 
   data.write(buffer_in[first.read()]);
+  service.write(buffer_in[(first.read() + 2) & (depth - 1)]);
 
 }
 
@@ -96,11 +97,23 @@ void fila::out_proc_data()
 // Em S_END  indicado que o ltimo flit deve ser transmitido (data_av='1') quando  recebida a
 // confirmao da transmisso (data_ack='1') a mquina retorna ao estado S_INIT.
 
+// O PACOTE NA CABECA DA FILA PODE PEDIR ROTEAMENTO. COM CLASSIFY, A ESCOLHA DO CANAL VIRTUAL
+// E DO CAMINHO PELO SERVICO ESPERA O TERCEIRO FLIT, OU O PAYLOAD DE TAMANHO ZERO QUE NAO O TEM.
+// A FILA DEVE TER BUFFER_TAM_CLASSIFY FLITS, SENAO O CREDITO CAI ANTES DO TERCEIRO FLIT
+bool fila::header_ready(){
+	unsigned int local_occupancy = occupancy();
+
+	if (!classify)
+		return true;
+
+	return local_occupancy >= 3 || (local_occupancy == 2 && buffer_in[(first.read() + 1) & (depth - 1)] == 0);
+}
+
 void fila::out_proc_FSM(){
 	bool local_ack_h;
 	bool local_data_ack;
-	sc_uint<4> local_first;
-	sc_uint<4> local_last;
+	sc_uint<BUFFER_PTR_BITS> local_first;
+	sc_uint<BUFFER_PTR_BITS> local_last;
 	regflit	local_counter_flit;
 	
 	if(reset_n.read()==false){
@@ -122,7 +135,7 @@ void fila::out_proc_FSM(){
 				counter_flit.write(0);
 				h.write(false);
 				data_av.write(false);
-				if(local_first != local_last){ // detectou dado na fila
+				if(local_first != local_last && header_ready()){ // detectou dado na fila
 					h.write(true);
 					EA.write(S_HEADER);
 				}
@@ -146,7 +159,7 @@ void fila::out_proc_FSM(){
 			case S_SENDHEADER:
 				if(local_data_ack==true){//confirmao do envio do header
 					//retira o header do buffer e se tem dado no buffer pede envio do mesmo
-					if(local_first==(BUFFER_TAM-1)){
+					if(local_first==(depth-1)){
 						first.write(0);
 						if(local_last!=0)
 							data_av.write(true);
@@ -175,7 +188,7 @@ void fila::out_proc_FSM(){
 					else
 						counter_flit.write(local_counter_flit - 1);
 					//retira um dado do buffer e se tem dado no buffer pede envio do mesmo
-					if(local_first == (BUFFER_TAM-1)){
+					if(local_first == (depth-1)){
 						first.write(0);
 						if(local_last!=0)
 							data_av.write(true);
@@ -196,7 +209,7 @@ void fila::out_proc_FSM(){
 				else{
 					if(local_data_ack==true && local_counter_flit==1){//confirmao do envio do tail
 						//retira um dado do buffer
-						if(local_first==(BUFFER_TAM-1)){
+						if(local_first==(depth-1)){
 							first.write(0);
 						}
 						else{
@@ -230,3 +243,16 @@ void fila::out_proc_FSM(){
 		}
 	}
 }
+
+void fila::checkpoint(Checkpoint &ckp){
+
+	ckp.io(EA);
+	ckp.io(PE);
+	ckp.expect(depth);
+	ckp.io(buffer_in, depth);
+	ckp.io(first);
+	ckp.io(last);
+	ckp.io(tem_espaco_na_fila);
+	ckp.io(auxack_rx);
+	ckp.io(counter_flit);
+}
@@ -30,15 +30,18 @@ SC_MODULE(fila){
   sc_in<bool > ack_h;
   sc_out<bool > data_av;
   sc_out<regflit > data;
+  sc_out<regflit > service;	// Third flit of the packet at the head, read by switch_control
   sc_in<bool > data_ack;
   sc_out<bool > sender;
 
   enum fila_out{S_INIT, S_PAYLOAD, S_SENDHEADER, S_HEADER, S_END, S_END2};
   sc_signal<fila_out > EA, PE;
 
-  regflit buffer_in[BUFFER_TAM];
+  regflit *buffer_in;
+  unsigned int depth;		// Power of two, from BUFFER_TAM_MIN to BUFFER_TAM_MAX
+  bool classify;			// Holds the routing request until the service flit is buffered
 
-  sc_signal<sc_uint<4> >  first,last;
+  sc_signal<sc_uint<BUFFER_PTR_BITS> >  first,last;
   sc_signal<bool > tem_espaco_na_fila, auxack_rx;
   sc_signal<regflit > counter_flit;
 
@@ -46,11 +49,21 @@ SC_MODULE(fila){
   void in_proc_updPtr();
 
   void out_proc_data();
+  bool header_ready();
   void out_proc_FSM();
   void change_state_sequ();
   void change_state_comb();
+  void checkpoint(Checkpoint &ckp);
+
+  // Flits in the buffer
+  unsigned int occupancy() { return (unsigned int)(last.read() - first.read()) & (depth - 1); }
+
+  SC_HAS_PROCESS(fila);
+  fila(sc_module_name name_, unsigned int depth_ = BUFFER_TAM, bool classify_ = false) :
+  sc_module(name_), depth(depth_), classify(classify_)
+  {
+    buffer_in = new regflit[depth];
 
-  SC_CTOR(fila){
     SC_METHOD(in_proc_FSM);
     sensitive << reset_n.neg();
     sensitive << clock.pos();
@@ -18,21 +18,19 @@
 
 void router_cc::traffic_monitor(){
 	int i;
-	char aux[255];
-	FILE *fp;
 
 	if(reset_n.read() == 0){
-		for(i = 0; i < NPORT; i++) {
+		for(i = 0; i < NCHANNEL; i++) {
 			bandwidth_allocation[i] = 0;
 			SM_traffic_monitor[i] = 0;
 		}
 	}
 	else if (clock.read() == 1){
 
-		for(i = 0; i < NPORT; i++){
+		for(i = 0; i < NCHANNEL; i++){
 
-			//New flit coming
-			if(rx[i].read() && credit_o[i]){
+			//New flit coming on the virtual channel
+			if(sgn_rx[i].read() && sgn_credit_o[i].read()){
 
 				if (payload_counter[i] != 0)
 					payload_counter[i]--;
@@ -47,20 +45,20 @@ void router_cc::traffic_monitor(){
 
 					case 0: //Header
 						SM_traffic_monitor[i] = 1;
-						target_router[i] = data_in[i].read() & 0xFFFF;
+						target_router[i] = data_in[i / VC_MAX].read() & 0xFFFF;
 						header_time[i] = (unsigned int)tick_counter.read();
 						
-						//printf("%d   --      %d\n",  (unsigned int)data_in[i].read(), target_router[i]); //debug
+						//printf("%d   --      %d\n",  (unsigned int)data_in[i / VC_MAX].read(), target_router[i]); //debug
 						break;
 
 					case 1: //Payload
-						payload[i] = data_in[i].read();
+						payload[i] = data_in[i / VC_MAX].read();
 						SM_traffic_monitor[i] = 2;
-						payload_counter[i] = data_in[i].read();
+						payload_counter[i] = data_in[i / VC_MAX].read();
 						break;					
 
 					case 2: //Service
-						service[i] = data_in[i].read();
+						service[i] = data_in[i / VC_MAX].read();
 
 						if(service[i] != 0x40 && service[i] != 0x70 && service[i] != 0x221 && service[i] != 0x10 && service[i] != 0x20)
 							SM_traffic_monitor[i] = 5;
@@ -70,7 +68,7 @@ void router_cc::traffic_monitor(){
 
 					case 3: //If is task_allocation
 
-						task_id[i] = data_in[i].read();
+						task_id[i] = data_in[i / VC_MAX].read();
 						if (service[i] == 0x10 || service[i] == 0x20)
 							SM_traffic_monitor[i] = 4;
 						else
@@ -79,40 +77,46 @@ void router_cc::traffic_monitor(){
 						break;
 
 					case 4:
-						consumer_id[i] = data_in[i].read();
+						consumer_id[i] = data_in[i / VC_MAX].read();
 						SM_traffic_monitor[i] = 5;
 						break;
 
 					case 5:
 
+						//Flits of the service header that identify the packet, see latency.h
+						if (payload[i] + 1 - payload_counter[i] == LATENCY_SOURCE_FLIT)
+							source_pe[i] = data_in[i / VC_MAX].read();
+						else if (payload[i] + 1 - payload_counter[i] == LATENCY_TIMESTAMP_FLIT)
+							Latency::hop(Latency::key(source_pe[i], target_router[i], data_in[i / VC_MAX].read()), service[i], header_time[i]);
+
 						if (payload_counter[i] == 0 ){
 							
-							//Store in aux the C's string way
-							sprintf(aux, "debug/traffic_router.txt");
-
-							//unsigned int aux2 = (unsigned int)address;
-							//unsigned int newAdress = ((aux2 >> 8) << 4) | (aux2 & 0xFF);
-							unsigned int newAdress = (unsigned int)address;
-							//aux2 = target_router[i];
-							//unsigned int targetRouter = ((aux2 >> 8) << 4) | (aux2 & 0xFF);
-							unsigned int targetRouter = target_router[i];
-
-
-							// Open a file called "aux" deferred on append mode
-							fp = fopen (aux, "a");
-
-							if (service[i] != 0x40 && service[i] != 0x70 && service[i] != 0x221 && service[i] != 0x10 && service[i] != 0x20){
-								sprintf(aux, "%d\t%d\t%x\t%d\t%d\t%d\t%d\n", header_time[i], newAdress, service[i], payload[i], bandwidth_allocation[i], i, targetRouter);
-							} else {
-								if (service[i] == 0x10 || service[i] == 0x20)
-									sprintf(aux, "%d\t%d\t%x\t%d\t%d\t%d\t%d\t%d\t%d\n", header_time[i], newAdress, service[i], payload[i], bandwidth_allocation[i], i, targetRouter, task_id[i], consumer_id[i]);
-								else
-									sprintf(aux, "%d\t%d\t%x\t%d\t%d\t%d\t%d\t%d\n", header_time[i], newAdress, service[i], payload[i], bandwidth_allocation[i], i, targetRouter, task_id[i]);
-
-							}
-
-							fprintf(fp,"%s",aux);
-							fclose (fp);
+							TrafficRecord record;
+
+							record.time = header_time[i];
+							record.service = service[i];
+							record.router = (unsigned int)address;
+							record.target = target_router[i];
+							record.payload = payload[i];
+							record.bandwidth = bandwidth_allocation[i];
+							record.port = i / VC_MAX;
+							record.task_id = 0;
+							record.consumer_id = 0;
+							record.reserved = 0;
+
+							if (service[i] != 0x40 && service[i] != 0x70 && service[i] != 0x221 && service[i] != 0x10 && service[i] != 0x20)
+								record.fields = 7;
+							else if (service[i] == 0x10 || service[i] == 0x20)
+								record.fields = 9;
+							else
+								record.fields = 8;
+
+							if (record.fields >= 8)
+								record.task_id = task_id[i];
+							if (record.fields == 9)
+								record.consumer_id = consumer_id[i];
+
+							traffic_log->write((const char*)&record, sizeof(record));
 
 							bandwidth_allocation[i] = 0;
 							SM_traffic_monitor[i] = 0;
@@ -129,72 +133,75 @@ void router_cc::traffic_monitor(){
 	}
 
 void router_cc::upd_header(){
-         if(incoming.read()==EAST) header.write(data[EAST].read());
-    else if(incoming.read()==WEST) header.write(data[WEST].read());
-    else if(incoming.read()==NORTH) header.write(data[NORTH].read());
-    else if(incoming.read()==SOUTH) header.write(data[SOUTH].read());
-    else if(incoming.read()==LOCAL) header.write(data[LOCAL].read());
+         if(incoming.read()==EAST) header.write(data[EAST*VC_MAX].read());
+    else if(incoming.read()==WEST) header.write(data[WEST*VC_MAX].read());
+    else if(incoming.read()==NORTH) header.write(data[NORTH*VC_MAX].read());
+    else if(incoming.read()==SOUTH) header.write(data[SOUTH*VC_MAX].read());
+    else if(incoming.read()==LOCAL) header.write(data[LOCAL*VC_MAX].read());
 }
 
-void router_cc::upd_dataout(){
-	reg_mux localmux_out;
-	localmux_out = mux_out.read();
-	
-	for (int i=0; i<NPORT; i++){
-		sc_uint<3> j=localmux_out.range(i*3+2,i*3);
-		//Removido warning - codigo antigo: if (i==j){
-		if (i==((int)j)){
-			data_out[i].write(0);
-		}
-		else{
-			if (free[i].read()==0){
-				data_out[i].write(data[j]);
-			}
-		}
+//Flits of the link to the queue of their virtual channel
+void router_cc::upd_rx(){
+	for (int c=0; c<NCHANNEL; c++){
+		if (myQueue[c] != NULL)
+			sgn_rx[c].write(rx[c / VC_MAX].read() && vc_in[c / VC_MAX].read() == (unsigned int)(c % VC_MAX));
 	}
 }
 
+void router_cc::upd_sgn_credit_o(){
+	for (int i=0; i<NPORT; i++){
+		regcredit credit = 0;
+		for (unsigned int v=0; v<vcs[i]; v++)
+			credit[v] = sgn_credit_o[i*VC_MAX + v].read();
+		credit_o[i].write(credit);
+	}
+}
 
-void router_cc::upd_dataack(){
-	reg_mux local_mux_in;
-	
+//Each output sends a flit per cycle from one of its connected virtual channels, in round robin,
+//preferring the ones with credit. With a single virtual channel it is the wormhole connection
+void router_cc::upd_crossbar(){
+	bool data_ack[NCHANNEL];
 
-	local_mux_in=mux_in.read();
+	for (int c=0; c<NCHANNEL; c++)
+		data_ack[c] = false;
 
 	for (int i=0; i<NPORT; i++){
-		int j=local_mux_in.range(i*3+2,i*3);
-		if (i==j){
-			sgn_data_ack[i].write(0);
-		}
-		else{
-			if (sgn_data_av[i].read()==1){
-				sgn_data_ack[i].write(credit_i[j]);
+		int selected = -1;
+		unsigned int selected_vc = 0;
+
+		for (unsigned int k=0; k<vcs[i]; k++){
+			unsigned int v = (vc_next[i].read() + k) % vcs[i];
+			int out = i*VC_MAX + v;
+			int in = mux_out[out].read();
+
+			if (free[out].read()==1 || in == out || sgn_data_av[in].read()==0)
+				continue;
+
+			if (credit_i[i].read()[v]){
+				selected = in;
+				selected_vc = v;
+				break;
 			}
-			else{
-				sgn_data_ack[i].write(0);
+			if (selected < 0){
+				selected = in;
+				selected_vc = v;
 			}
 		}
-	}
-	
-}
-
 
-void router_cc::upd_tx(){
-	reg_mux local_mux_out=mux_out.read();
-
-	for (int i=0; i<NPORT; i++){
-		int j=local_mux_out.range(i*3+2,i*3);
-		if (i==j){
-			tx[i].write(0);
+		if (selected >= 0){
+			data_out[i].write(data[selected]);
+			vc_out[i].write(selected_vc);
+			tx[i].write(1);
+			data_ack[selected] = credit_i[i].read()[selected_vc];
 		}
 		else{
-			if (free[i].read()==0){
-				tx[i].write(sgn_data_av[j]);
-			}
+			tx[i].write(0);
 		}
 	}
-}
 
+	for (int c=0; c<NCHANNEL; c++)
+		sgn_data_ack[c].write(data_ack[c]);
+}
 
 void router_cc::upd_clock_tx(){
 	
@@ -214,14 +221,29 @@ void router_cc::upd_clock_tx(){
 			fluxo_5=0;
 			
 			aux=0;
+
+			for(int i=0; i<NPORT; i++){
+				counters[i].flits_in = counters[i].flits_out = counters[i].packets = 0;
+				counters[i].credit_blocked = counters[i].arbitration_wait = 0;
+				counters[i].occupancy.assign(vcs[i] * noc.buffer_depth, 0);
+				vc_next[i].write(0);
+			}
+			active_cycles=0;
 			
 		}
 		else{
-			if((tx[0].read() == 1 and credit_i[0].read() == 1) or (tx[1].read() == 1 and credit_i[1].read() == 1) or (tx[2].read() == 1 and credit_i[2].read() == 1) or
-				(tx[3].read() == 1 and credit_i[3].read() == 1) or (tx[4].read() == 1 and credit_i[4].read() == 1)){
+			count();
+
+			for(int i=0; i<NPORT; i++){
+				if(sent(i))
+					vc_next[i].write((vc_out[i].read() + 1) % vcs[i]);
+			}
+
+			if(sent(0) or sent(1) or sent(2) or
+				sent(3) or sent(4)){
 					
-				aux=(tx[0].read() == 1 and credit_i[0].read() == 1) + (tx[1].read() == 1 and credit_i[1].read() == 1) + (tx[2].read() == 1 and credit_i[2].read() == 1) + 
-					(tx[3].read() == 1 and credit_i[3].read() == 1) + (tx[4].read() == 1 and credit_i[4].read() == 1);
+				aux=sent(0) + sent(1) + sent(2) + 
+					sent(3) + sent(4);
 					
 				
 				if(aux == 1){
@@ -242,22 +264,22 @@ void router_cc::upd_clock_tx(){
 				}
 						
 					
-				if((tx[0].read() == 1 and credit_i[0].read() == 1)){
+				if(sent(0)){
 					wire_EAST++;
 				}
-				else if((tx[1].read() == 1 and credit_i[1].read() == 1)){
+				else if(sent(1)){
 
 					wire_WEST++;
 				}
-				else if((tx[2].read() == 1 and credit_i[2].read() == 1)){
+				else if(sent(2)){
 
 					wire_NORTH++;
 				}				
-				else if((tx[3].read() == 1 and credit_i[3].read() == 1)){
+				else if(sent(3)){
 
 					wire_SOUTH++;
 				}				
-				else if((tx[4].read() == 1 and credit_i[4].read() == 1)){
+				else if(sent(4)){
 
 					wire_LOCAL++;
 				}
@@ -269,4 +291,117 @@ void router_cc::upd_clock_tx(){
 		}
 }
 
+void router_cc::count(){
+	active_cycles++;
+
+	for (int i=0; i<NPORT; i++){
+		unsigned int ack_h = 0;
+		bool h = false;
+		unsigned int occupancy = 0;
+
+		if (received(i))
+			counters[i].flits_in++;
+
+		if (tx[i].read()){
+			if (sent(i))
+				counters[i].flits_out++;
+			else
+				counters[i].credit_blocked++;
+		}
+
+		for (unsigned int v=0; v<vcs[i]; v++){
+			int c = i*VC_MAX + v;
+			ack_h += sgn_ack_h[c].read();
+			h = h || sgn_h[c].read();
+			occupancy += myQueue[c]->occupancy();
+		}
+
+		// ack_h is high for one cycle when switch_control connects an input channel, and
+		// several channels of the port can be connected in the same cycle
+		if (ack_h)
+			counters[i].packets += ack_h;
+		else if (h)
+			counters[i].arbitration_wait++;
 
+		counters[i].occupancy[occupancy]++;
+	}
+}
+
+//No flit buffered, in flight or being routed
+bool router_cc::idle(){
+	if (!mySwitchControl->idle())
+		return false;
+
+	for (int i=0; i<NPORT; i++){
+		if (rx[i].read())
+			return false;
+	}
+
+	for (int c=0; c<NCHANNEL; c++){
+		if (myQueue[c] != NULL && (myQueue[c]->first.read() != myQueue[c]->last.read() || myQueue[c]->EA.read() != fila::S_INIT))
+			return false;
+		if (!free[c].read() || sgn_sender[c].read() || SM_traffic_monitor[c] != 0)
+			return false;
+	}
+
+	return true;
+}
+
+void router_cc::checkpoint(Checkpoint &ckp){
+
+	ckp.expect(noc.vcs);
+	ckp.io(sgn_h);
+	ckp.io(sgn_ack_h);
+	ckp.io(sgn_data_av);
+	ckp.io(sgn_sender);
+	ckp.io(sgn_data_ack);
+	ckp.io(sgn_rx);
+	ckp.io(sgn_credit_o);
+	ckp.io(incoming);
+	ckp.io(data);
+	ckp.io(service_flit);
+	ckp.io(mux_in);
+	ckp.io(mux_out);
+	ckp.io(header);
+	ckp.io(free);
+	ckp.io(vc_next);
+
+	ckp.io(SM_traffic_monitor);
+	ckp.io(target_router);
+	ckp.io(header_time);
+	ckp.io(bandwidth_allocation);
+	ckp.io(payload);
+	ckp.io(payload_counter);
+	ckp.io(service);
+	ckp.io(task_id);
+	ckp.io(consumer_id);
+	ckp.io(source_pe);
+
+	ckp.io(total_flits);
+	ckp.io(wire_EAST);
+	ckp.io(wire_WEST);
+	ckp.io(wire_NORTH);
+	ckp.io(wire_SOUTH);
+	ckp.io(wire_LOCAL);
+	ckp.io(fluxo_0);
+	ckp.io(fluxo_1);
+	ckp.io(fluxo_2);
+	ckp.io(fluxo_3);
+	ckp.io(fluxo_4);
+	ckp.io(fluxo_5);
+
+	for(int i=0; i<NPORT; i++){
+		ckp.io(counters[i].flits_in);
+		ckp.io(counters[i].flits_out);
+		ckp.io(counters[i].packets);
+		ckp.io(counters[i].credit_blocked);
+		ckp.io(counters[i].arbitration_wait);
+		ckp.io(counters[i].occupancy.data(), counters[i].occupancy.size());
+	}
+	ckp.io(active_cycles);
+
+	for(int c=0; c<NCHANNEL; c++)
+		if (myQueue[c] != NULL)
+			myQueue[c]->checkpoint(ckp);
+	mySwitchControl->checkpoint(ckp);
+}
@@ -16,53 +16,93 @@
 #define _switch_cc_h
 
 #include <systemc.h>
+#include <vector>
 #include "../../standards.h"
+#include "../../logger.h"
+#include "../../latency.h"
 #include "queue.h"
 #include "switchcontrol.h"
 
+// Packet of debug/traffic_router.bin, little-endian, in the order the packets end.
+// hemps-trace2txt sorts them by time into the traffic_router.txt of the HeMPS Debugger
+struct TrafficRecord {
+	uint32_t time;			// Tick of the header
+	uint32_t service;
+	uint32_t task_id;
+	uint32_t consumer_id;
+	uint16_t router;		// Router that saw the packet
+	uint16_t target;
+	uint16_t payload;
+	uint16_t bandwidth;		// Cycles from the header to the last flit
+	uint8_t port;
+	uint8_t fields;			// Fields of the text line: 7, 8 with task_id or 9 with consumer_id
+	uint16_t reserved;
+};
+
+// NoC counters of a router port, counted on the router clock edges
+struct PortCounters {
+	unsigned long flits_in;					// Flits stored in the input buffer
+	unsigned long flits_out;				// Flits sent by the output
+	unsigned long packets;					// Packets routed from the input
+	unsigned long credit_blocked;			// Cycles the output had a flit and no credit
+	unsigned long arbitration_wait;			// Cycles the input header waited for switch_control
+	std::vector<unsigned long> occupancy;	// Cycles with each number of flits in the input buffer
+};
+
 SC_MODULE(router_cc){
 
   sc_in<bool >			clock;
   sc_in<bool >			reset_n;
   
+  // Links: the flits carry their virtual channel in vc_in/vc_out and credit has a bit per virtual channel
   sc_in<bool > 			clock_rx[NPORT];
   sc_in<bool >			rx[NPORT];
-  sc_out<bool >			credit_o[NPORT];
+  sc_in<regvc >			vc_in[NPORT];
+  sc_out<regcredit >	credit_o[NPORT];
   sc_out<regflit >		data_out[NPORT];
+  sc_out<regvc >		vc_out[NPORT];
 
   sc_out<bool>			clock_tx[NPORT];
   sc_out<bool >			tx[NPORT];
-  sc_in<bool >			credit_i[NPORT];
+  sc_in<regcredit >		credit_i[NPORT];
   sc_in<regflit >		data_in[NPORT];
   
-  sc_signal<bool >		sgn_h[NPORT];
-  sc_signal<bool >		sgn_ack_h[NPORT];
-  sc_signal<bool >		sgn_data_av[NPORT];
-  sc_signal<bool >		sgn_sender[NPORT];
-  sc_signal<bool >		sgn_data_ack[NPORT];
+  // Channels, port*VC_MAX + virtual channel
+  sc_signal<bool >		sgn_h[NCHANNEL];
+  sc_signal<bool >		sgn_ack_h[NCHANNEL];
+  sc_signal<bool >		sgn_data_av[NCHANNEL];
+  sc_signal<bool >		sgn_sender[NCHANNEL];
+  sc_signal<bool >		sgn_data_ack[NCHANNEL];
+  sc_signal<bool >		sgn_rx[NCHANNEL];
+  sc_signal<bool >		sgn_credit_o[NCHANNEL];
   sc_signal<reg3 >		incoming;
-  sc_signal<regflit >	data[NPORT];
+  sc_signal<regflit >	data[NCHANNEL];
+  sc_signal<regflit >	service_flit[NCHANNEL];
   
-  sc_signal<reg_mux >	mux_in, mux_out;
+  sc_signal<regchannel >	mux_in[NCHANNEL], mux_out[NCHANNEL];
   sc_signal<regflit >	header;
-  sc_signal<bool >		free[NPORT];
+  sc_signal<bool >		free[NCHANNEL];
+  sc_signal<regvc >		vc_next[NPORT];		// Round robin of the virtual channels sharing an output
 
-  //Traffic monitor
+  //Traffic monitor, per input channel
 	sc_in<sc_uint<32 > > tick_counter;
-	unsigned char SM_traffic_monitor[NPORT];
-	unsigned int target_router[NPORT];
-	unsigned int header_time[NPORT];
-	unsigned short bandwidth_allocation[NPORT];
-	unsigned short payload[NPORT];
-	unsigned short payload_counter[NPORT];
-	unsigned int service[NPORT];
-	unsigned int task_id[NPORT];
-	unsigned int consumer_id[NPORT];
+	Logger::Log *traffic_log;
+	unsigned char SM_traffic_monitor[NCHANNEL];
+	unsigned int target_router[NCHANNEL];
+	unsigned int header_time[NCHANNEL];
+	unsigned short bandwidth_allocation[NCHANNEL];
+	unsigned short payload[NCHANNEL];
+	unsigned short payload_counter[NCHANNEL];
+	unsigned int service[NCHANNEL];
+	unsigned int task_id[NCHANNEL];
+	unsigned int consumer_id[NCHANNEL];
+	unsigned int source_pe[NCHANNEL];
 	void traffic_monitor();
 
 
-  // interface do Fila
-  fila	*myQueue[NPORT];
+  // interface do Fila, NULL for the channels above the virtual channels of the port
+  fila	*myQueue[NCHANNEL];
+  unsigned int vcs[NPORT];
     
   switch_control *mySwitchControl;
  
@@ -80,11 +120,17 @@ SC_MODULE(router_cc){
    int fluxo_3;
    int fluxo_4;
    int fluxo_5;
+
+   // Counters per port. Cycles without clock, skipped while the PE is idle, are not counted
+   NocConfig noc;
+   PortCounters counters[NPORT];
+   unsigned long active_cycles;
+   void count();
+   bool sent(int port) { return tx[port].read() && credit_i[port].read()[(int)vc_out[port].read()]; }
+   bool received(int port) { return rx[port].read() && credit_o[port].read()[(int)vc_in[port].read()]; }
    
   void upd_header();
-  void upd_dataout();
-  void upd_dataack();
-  void upd_tx();
+  void upd_crossbar();
   void upd_ackh();
   void upd_sgndataack();
   void upd_dataav();
@@ -95,91 +141,93 @@ SC_MODULE(router_cc){
   void upd_sgnackrx();
   void upd_sgn_credit_o();
   void upd_clock_tx();
+  bool idle();
+  void checkpoint(Checkpoint &ckp);
 
 	SC_HAS_PROCESS(router_cc);
-	router_cc(sc_module_name name_, regaddress address_ = 0x0000) :
-	sc_module(name_), address(address_)
+	router_cc(sc_module_name name_, regaddress address_ = 0x0000, const NocConfig &noc_ = NocConfig()) :
+	sc_module(name_), noc(noc_), address(address_)
 	{
 		char temp[20];
    
-		unsigned int i;
+		unsigned int i, v, c;
 				
 		for(i=0; i<NPORT; i++)
 		{
-			memset(temp, 0, sizeof(temp)); sprintf(temp,"fila%d",i);
-			myQueue[i] = new fila(temp);
-			myQueue[i]->clock(clock);
-			myQueue[i]->reset_n(reset_n);
-			myQueue[i]->data_in(data_in[i]);
-			myQueue[i]->rx(rx[i]);
-			myQueue[i]->credit_o(credit_o[i]);
-			myQueue[i]->h(sgn_h[i]);
-			myQueue[i]->ack_h(sgn_ack_h[i]);
-			myQueue[i]->data_av(sgn_data_av[i]);
-			myQueue[i]->data(data[i]);
-			myQueue[i]->data_ack(sgn_data_ack[i]);
-			myQueue[i]->sender(sgn_sender[i]);
+			vcs[i] = (i == LOCAL) ? 1 : noc.vcs;
+			counters[i].occupancy.resize(vcs[i] * noc.buffer_depth);
+
+			for(v=0; v<VC_MAX; v++)
+			{
+				c = i*VC_MAX + v;
+				myQueue[c] = NULL;
+				if (v >= vcs[i])
+					continue;
+
+				memset(temp, 0, sizeof(temp)); sprintf(temp,"fila%d_%d",i,v);
+				myQueue[c] = new fila(temp, noc.buffer_depth, noc.classify(i));
+				myQueue[c]->clock(clock);
+				myQueue[c]->reset_n(reset_n);
+				myQueue[c]->data_in(data_in[i]);
+				myQueue[c]->rx(sgn_rx[c]);
+				myQueue[c]->credit_o(sgn_credit_o[c]);
+				myQueue[c]->h(sgn_h[c]);
+				myQueue[c]->ack_h(sgn_ack_h[c]);
+				myQueue[c]->data_av(sgn_data_av[c]);
+				myQueue[c]->data(data[c]);
+				myQueue[c]->service(service_flit[c]);
+				myQueue[c]->data_ack(sgn_data_ack[c]);
+				myQueue[c]->sender(sgn_sender[c]);
+			}
 		}
 
-		mySwitchControl = new switch_control("novoswitchcontrol",address);
+		mySwitchControl = new switch_control("novoswitchcontrol",address,noc);
 		mySwitchControl->clock(clock);
 		mySwitchControl->reset(reset_n);
-		for(i=0; i<NPORT; i++){
-			mySwitchControl->data[i](data[i]);
-			mySwitchControl->h[i](sgn_h[i]);
-			mySwitchControl->ack_h[i](sgn_ack_h[i]);
-			mySwitchControl->sender[i](sgn_sender[i]);
-			mySwitchControl->free[i](free[i]);
+		for(c=0; c<NCHANNEL; c++){
+			mySwitchControl->data[c](data[c]);
+			mySwitchControl->service[c](service_flit[c]);
+			mySwitchControl->h[c](sgn_h[c]);
+			mySwitchControl->ack_h[c](sgn_ack_h[c]);
+			mySwitchControl->sender[c](sgn_sender[c]);
+			mySwitchControl->free[c](free[c]);
+			mySwitchControl->mux_in[c](mux_in[c]);
+			mySwitchControl->mux_out[c](mux_out[c]);
 		}
-		mySwitchControl->mux_in(mux_in);
-		mySwitchControl->mux_out(mux_out);
+		for(i=0; i<NPORT; i++)
+			mySwitchControl->credit[i](credit_i[i]);
 
 		SC_METHOD(upd_header);
 		sensitive << incoming;
-		sensitive << data[EAST];
-		sensitive << data[WEST];
-		sensitive << data[NORTH];
-		sensitive << data[SOUTH];
-		sensitive << data[LOCAL];
-
-		SC_METHOD(upd_dataout);
-		sensitive << free[EAST];
-		sensitive << free[WEST];
-		sensitive << free[NORTH];
-		sensitive << free[SOUTH];
-		sensitive << free[LOCAL];
-		sensitive << data[EAST];
-		sensitive << data[WEST];
-		sensitive << data[NORTH];
-		sensitive << data[SOUTH];
-		sensitive << data[LOCAL];
-		sensitive << mux_out;
-
-		SC_METHOD(upd_dataack);
-		sensitive << credit_i[EAST];
-		sensitive << credit_i[WEST];
-		sensitive << credit_i[NORTH];
-		sensitive << credit_i[SOUTH];
-		sensitive << credit_i[LOCAL];
-		sensitive << mux_in;
-		sensitive << sgn_data_av[EAST];
-		sensitive << sgn_data_av[WEST];
-		sensitive << sgn_data_av[NORTH];
-		sensitive << sgn_data_av[SOUTH];
-		sensitive << sgn_data_av[LOCAL];
-
-		SC_METHOD(upd_tx);
-		sensitive << free[EAST];
-		sensitive << free[WEST];
-		sensitive << free[NORTH];
-		sensitive << free[SOUTH];
-		sensitive << free[LOCAL];
-		sensitive << sgn_data_av[EAST];
-		sensitive << sgn_data_av[WEST];
-		sensitive << sgn_data_av[NORTH];
-		sensitive << sgn_data_av[SOUTH];
-		sensitive << sgn_data_av[LOCAL];
-		sensitive << mux_out;		
+		sensitive << data[EAST*VC_MAX];
+		sensitive << data[WEST*VC_MAX];
+		sensitive << data[NORTH*VC_MAX];
+		sensitive << data[SOUTH*VC_MAX];
+		sensitive << data[LOCAL*VC_MAX];
+
+		SC_METHOD(upd_rx);
+		for(i=0; i<NPORT; i++){
+			sensitive << rx[i];
+			sensitive << vc_in[i];
+		}
+
+		SC_METHOD(upd_sgn_credit_o);
+		for(c=0; c<NCHANNEL; c++)
+			sensitive << sgn_credit_o[c];
+
+		SC_METHOD(upd_crossbar);
+		for(c=0; c<NCHANNEL; c++){
+			sensitive << free[c];
+			sensitive << data[c];
+			sensitive << sgn_data_av[c];
+			sensitive << mux_out[c];
+		}
+		for(i=0; i<NPORT; i++){
+			sensitive << credit_i[i];
+			sensitive << vc_next[i];
+		}
+
+		traffic_log = Logger::open("debug/traffic_router.bin");
 
 		SC_METHOD(traffic_monitor);
 		sensitive << clock;
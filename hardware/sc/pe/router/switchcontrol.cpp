@@ -14,260 +14,230 @@
 
 #include "switchcontrol.h"
 
-void switch_control::controle_comb(){
-	regquartoflit lx_local,ly_local,tx_local,ty_local;
-	
+//Alocador separavel, entrada primeiro. Cada canal de entrada com rota calculada pede um canal
+//de saida: entre as portas permitidas e livres, prefere a que tem credito no vizinho. Cada canal
+//de saida livre concede a um dos pedidos, em round robin a partir de prio. Pedidos a saidas
+//diferentes sao concedidos no mesmo ciclo
+void switch_control::allocator_comb(){
+	int local_request[NCHANNEL];
+	int out, v;
 	
-	lx_local=lx.read();
-	ly_local=ly.read();
-	tx_local=tx.read();
-	ty_local=ty.read();
+	for(int c=0; c<NCHANNEL; c++){
+		local_request[c] = -1;
+		if(routed[c].read()==0)
+			continue;
 		
-	switch(EA.read()){
-		case S0:
-			PE.write(S1);
-		break;
-		case S1:
-			if(ask.read()==1){
-				PE.write(S2);
-			}
-			else{
-				PE.write(S1);
-			}
-		break;
-		case S2:
-			PE.write(S3);
-		break;
-		case S3:
-			if(lx_local == tx_local && ly_local == ty_local && free[LOCAL].read()==1){
-				PE.write(S4);
-			}
-			else{
-				if(lx_local!=tx_local && free[dirx.read()].read()==1){
-					PE.write(S5);
-				}
-				else{
-					if( lx_local == tx_local && ly_local != ty_local && free[diry.read()].read()==1){
-						PE.write(S6);
-					}
-					else{
-						PE.write(S1);
-					}
-				}
+		v = out_vc[c].read();
+		if(route[c].read()[LOCAL]==1){
+			if(free[LOCAL*VC_MAX].read()==1)
+				local_request[c] = LOCAL*VC_MAX;
+			continue;
+		}
+		
+		out = -1;
+		for(int p=EAST; p<=SOUTH; p++){
+			if(route[c].read()[p]==0 || free[p*VC_MAX + v].read()==0)
+				continue;
+			if(credit[p].read()[v]==1){
+				out = p;
+				break;
 			}
-		break;
-		case S4:
-			PE.write(S7);
-		break;
-		case S5:
-			PE.write(S7);
-		break;
-		case S6:
-			PE.write(S7);
-		break;
-		case S7:
-			PE.write(S1);
-		break;
+			if(out < 0)
+				out = p;
+		}
+		if(out >= 0)
+			local_request[c] = out*VC_MAX + v;
 	}
-}
-
-void switch_control::state_sequ(){
-	if(reset.read()==0){
-		EA.write(S0);
+	
+	for(int c=0; c<NCHANNEL; c++){
+		request[c].write(local_request[c] < 0 ? 0 : local_request[c]);
+		grant[c].write(0);
 	}
-	else{
-		EA.write(PE.read());
+	
+	for(int o=0; o<NCHANNEL; o++){
+		if(free[o].read()==0)
+			continue;
+		for(int i=0; i<NCHANNEL; i++){
+			int c = (prio[o].read() + i) % NCHANNEL;
+			if(local_request[c] == o){
+				grant[c].write(1);
+				break;
+			}
+		}
 	}
 }
 
-		
+//A cada ciclo: conecta os canais concedidos, calcula a rota dos headers que chegaram e libera
+//as saidas dos pacotes que terminaram. ack_h fica alto um ciclo. A rota calculada num ciclo
+//disputa a alocacao no seguinte, enquanto a rota de outro header ja e calculada
 void switch_control::controle_sequ(){
-	reg_mux mux_in_local, mux_out_local;
+	regchannel mux_in_local[NCHANNEL];
+	regquartoflit lx_local,ly_local,tx_local,ty_local;
+	regmetadeflit header_local;
+	regchannel out;
 	
-		mux_out_local=mux_out.read();
-		mux_in_local=mux_in.read();
-
-		sender_ant[LOCAL].write(sender[LOCAL].read());
-		sender_ant[EAST].write(sender[EAST].read());
-		sender_ant[WEST].write(sender[WEST].read());
-		sender_ant[NORTH].write(sender[NORTH].read());
-		sender_ant[SOUTH].write(sender[SOUTH].read());
-
-		switch(EA.read()){
-			case S0://Zera variáveis
-				sel.write(0);
-				
-				ack_h[LOCAL].write(0);
-				ack_h[EAST].write(0);
-				ack_h[WEST].write(0);
-				ack_h[NORTH].write(0);
-				ack_h[SOUTH].write(0);
-				
-				free[LOCAL].write(1);
-				free[EAST].write(1);
-				free[WEST].write(1);
-				free[NORTH].write(1);
-				free[SOUTH].write(1);
-				
-				sender_ant[LOCAL].write(0);
-				sender_ant[EAST].write(0);
-				sender_ant[WEST].write(0);
-				sender_ant[NORTH].write(0);
-				sender_ant[SOUTH].write(0);
-				
-				mux_out.write(0);
-				mux_in.write(0);
-			break;
-			case S1://Chegou um header
-				ack_h[LOCAL].write(0);
-				ack_h[EAST].write(0);
-				ack_h[WEST].write(0);
-				ack_h[NORTH].write(0);
-				ack_h[SOUTH].write(0);
-			break;
-			case S2://Seleciona quem tera direito a requisitar roteamento
-				sel.write(prox.read());
-			break;
-			case S4://Estabelece a conexão com a porta LOCAL
-				mux_in_local.range(sel.read()*3+2,sel.read()*3)=LOCAL;
-				mux_in.write(mux_in_local);
-				
-				mux_out_local.range(LOCAL*3+2,LOCAL*3)=sel;
-				mux_out.write(mux_out_local);
-				
-				free[LOCAL].write(0);
-				
-				ack_h[sel.read()].write(1);
-				number_pck++;
-
-			break;
-			case S5://Estabelece a conexão com a porta EAST ou WEST
-				mux_in_local.range(sel.read()*3+2,sel.read()*3)=dirx.read();
-				mux_in.write(mux_in_local);
-				
-				mux_out_local.range(dirx.read()*3+2,dirx.read()*3)=sel;
-				mux_out.write(mux_out_local);
-				
-				free[dirx.read()].write(0);
-				
-				ack_h[sel.read()].write(1);
-			break;
-			case S6://Estabelece a conexão com a porta NORTH ou SOUTH
-				mux_in_local.range(sel.read()*3+2,sel.read()*3)=diry.read();
-				mux_in.write(mux_in_local);
-				
-				mux_out_local.range(diry.read()*3+2,diry.read()*3)=sel;
-				mux_out.write(mux_out_local);
-				
-				free[diry.read()].write(0);
-				
-				ack_h[sel.read()].write(1);
-			break;
-			default:
-				ack_h[sel.read()].write(0);
-			break;
+	if(reset.read()==0){
+		for(int c=0; c<NCHANNEL; c++){
+			ack_h[c].write(0);
+			free[c].write(1);
+			sender_ant[c].write(0);
+			mux_out[c].write(0);
+			mux_in[c].write(0);
+			routed[c].write(0);
+			route[c].write(0);
+			out_vc[c].write(0);
+			prio[c].write(0);
 		}
+		return;
+	}
+	
+	lx_local=address.range((METADEFLIT-1),QUARTOFLIT);
+	ly_local=address.range((QUARTOFLIT-1),0);
+	
+	for(int c=0; c<NCHANNEL; c++){
+		mux_in_local[c]=mux_in[c].read();
+		sender_ant[c].write(sender[c].read());
 		
-		if((sender[LOCAL].read()==0)&&(sender_ant[LOCAL].read()==1)){
-			free[mux_in_local.range(LOCAL*3+2,LOCAL*3)].write(1);
+		if(ack_h[c].read()==1){
+			//A fila baixa h no mesmo ciclo
+			ack_h[c].write(0);
 		}
-		if((sender[EAST].read()==0)&&(sender_ant[EAST].read()==1)){
-			free[mux_in_local.range(EAST*3+2,EAST*3)].write(1);
-		}
-		if((sender[WEST].read()==0)&&(sender_ant[WEST].read()==1)){
-			free[mux_in_local.range(WEST*3+2,WEST*3)].write(1);
+		else if(grant[c].read()==1){
+			out = request[c].read();
+			
+			mux_in_local[c]=out;
+			mux_in[c].write(out);
+			mux_out[out].write(c);
+			free[out].write(0);
+			prio[out].write((c + 1) % NCHANNEL);
+			
+			ack_h[c].write(1);
+			routed[c].write(0);
+			
+			if(out == LOCAL*VC_MAX)
+				number_pck++;
 		}
-		if((sender[NORTH].read()==0)&&(sender_ant[NORTH].read()==1)){
-			free[mux_in_local.range(NORTH*3+2,NORTH*3)].write(1);
+		else if(h[c].read()==1 && routed[c].read()==0){
+			header_local = data[c].read();
+			tx_local=header_local.range((METADEFLIT-1),QUARTOFLIT);
+			ty_local=header_local.range((QUARTOFLIT-1),0);
+			
+			route[c].write(routes(lx_local, ly_local, tx_local, ty_local, c / VC_MAX, noc.ordered(service[c].read())));
+			
+			//Pacotes injetados pela porta LOCAL escolhem o canal virtual pelo servico, os demais o mantem
+			if(c / VC_MAX == LOCAL)
+				out_vc[c].write(noc.vc(service[c].read()));
+			else
+				out_vc[c].write(c % VC_MAX);
+			
+			routed[c].write(1);
 		}
-		if((sender[SOUTH].read()==0)&&(sender_ant[SOUTH].read()==1)){
-			free[mux_in_local.range(SOUTH*3+2,SOUTH*3)].write(1);
+	}
+	
+	for(int c=0; c<NCHANNEL; c++){
+		if((sender[c].read()==0)&&(sender_ant[c].read()==1)){
+			free[mux_in_local[c]].write(1);
 		}
+	}
 }
 
-void switch_control::arbitro_comb(){
-	regmetadeflit header_local;
-	regquartoflit lx_local,ly_local,tx_local,ty_local;
-			
-	if(h[LOCAL].read()==1 || h[EAST].read()==1 || h[WEST].read()==1 || h[NORTH].read()==1 || h[SOUTH].read()==1){
-		ask.write(1);
+//Nenhum header sendo roteado ou conectado
+bool switch_control::idle(){
+	for(int c=0; c<NCHANNEL; c++){
+		if(routed[c].read() || ack_h[c].read())
+			return false;
 	}
-	else{
-		ask.write(0);
+	return true;
+}
+
+//Portas de saida que o algoritmo de roteamento permite para um pacote que entrou pela porta in.
+//Os algoritmos sao livres de deadlock pelo modelo de curvas: XY, west-first, north-last,
+//negative-first e odd-even. NORTH e o sentido de y crescente. Os servicos ordered seguem um
+//caminho unico, senao pacotes da mesma origem e destino se ultrapassam
+regNport switch_control::routes(int lx, int ly, int tx, int ty, int in, bool ordered){
+	regNport allowed = 0;
+	int dx = tx - lx;
+	int dy = ty - ly;
+	int x_dir = dx > 0 ? EAST : WEST;
+	int y_dir = dy > 0 ? NORTH : SOUTH;
+
+	if(dx == 0 && dy == 0){
+		allowed[LOCAL] = 1;
+		return allowed;
 	}
-	
 
-	switch(sel.read()){
-		case LOCAL:
-				if     (h[EAST ].read()==1) prox.write(EAST);
-				else if(h[WEST ].read()==1) prox.write(WEST);
-				else if(h[NORTH].read()==1) prox.write(NORTH);
-				else if(h[SOUTH].read()==1) prox.write(SOUTH);
-				else                 prox.write(LOCAL);
-				
-				header_local = data[LOCAL].read();
+	switch(noc.routing){
+		case ROUTING_WEST_FIRST://Todo o caminho a oeste primeiro, depois adaptativo
+			if(dx < 0){
+				allowed[WEST] = 1;
+			}
+			else{
+				if(dx > 0) allowed[EAST] = 1;
+				if(dy != 0) allowed[y_dir] = 1;
+			}
 		break;
-		case EAST:
-				if     (h[WEST ].read()==1) prox.write(WEST);
-				else if(h[NORTH].read()==1) prox.write(NORTH);
-				else if(h[SOUTH].read()==1) prox.write(SOUTH);
-				else if(h[LOCAL].read()==1) prox.write(LOCAL);
-				else                 prox.write(EAST);
-				
-				header_local = data[EAST].read();
+		case ROUTING_NORTH_LAST://Adaptativo ate so restar o caminho ao norte
+			if(dx == 0 && dy > 0){
+				allowed[NORTH] = 1;
+			}
+			else{
+				if(dx != 0) allowed[x_dir] = 1;
+				if(dy < 0) allowed[SOUTH] = 1;
+			}
 		break;
-		case WEST:
-				if     (h[NORTH].read()==1) prox.write(NORTH);
-				else if(h[SOUTH].read()==1) prox.write(SOUTH);
-				else if(h[LOCAL].read()==1) prox.write(LOCAL);
-				else if(h[EAST ].read()==1) prox.write(EAST);
-				else                 prox.write(WEST);
-				
-				header_local = data[WEST].read();
+		case ROUTING_NEGATIVE_FIRST://Adaptativo nos sentidos negativos, depois nos positivos
+			if(dx < 0 || dy < 0){
+				if(dx < 0) allowed[WEST] = 1;
+				if(dy < 0) allowed[SOUTH] = 1;
+			}
+			else{
+				if(dx > 0) allowed[EAST] = 1;
+				if(dy > 0) allowed[NORTH] = 1;
+			}
 		break;
-		case NORTH:
-				if     (h[SOUTH].read()==1) prox.write(SOUTH);
-				else if(h[LOCAL].read()==1) prox.write(LOCAL);
-				else if(h[EAST ].read()==1) prox.write(EAST);
-				else if(h[WEST ].read()==1) prox.write(WEST);
-				else                 prox.write(NORTH);
-				
-				header_local = data[NORTH].read();
+		case ROUTING_ODD_EVEN://Chiu: sem curvas de leste para norte/sul em colunas pares, nem de norte/sul para oeste em colunas impares
+			if(dx == 0){
+				allowed[y_dir] = 1;
+			}
+			else if(dx > 0){
+				if(dy == 0){
+					allowed[EAST] = 1;
+				}
+				else{
+					//Sem andar a leste o pacote segue na coluna da origem, que so entra pela WEST depois de andar a leste
+					if((lx % 2) == 1 || in != WEST) allowed[y_dir] = 1;
+					if((tx % 2) == 1 || dx != 1) allowed[EAST] = 1;
+				}
+			}
+			else{
+				allowed[WEST] = 1;
+				if((lx % 2) == 0 && dy != 0) allowed[y_dir] = 1;
+			}
 		break;
-		case SOUTH:
-				if     (h[LOCAL].read()==1) prox.write(LOCAL);
-				else if(h[EAST ].read()==1) prox.write(EAST);
-				else if(h[WEST ].read()==1) prox.write(WEST);
-				else if(h[NORTH].read()==1) prox.write(NORTH);
-				else                 prox.write(SOUTH);
-				header_local = data[SOUTH].read();
+		default://XY
+			if(dx != 0)
+				allowed[x_dir] = 1;
+			else
+				allowed[y_dir] = 1;
 		break;
 	}
-		
-	lx_local=address.range((METADEFLIT-1),QUARTOFLIT);
-	ly_local=address.range((QUARTOFLIT-1),0);
-	
-	lx.write(lx_local);
-	ly.write(ly_local);
 
-	tx_local=header_local.range((METADEFLIT-1),QUARTOFLIT);
-	ty_local=header_local.range((QUARTOFLIT-1),0);
-	
-	tx.write(tx_local);
-	ty.write(ty_local);
-	
-	
-	if(lx_local > tx_local){
-		dirx.write(WEST);
-	}
-	else{
-		dirx.write(EAST);
-	}
-	
-	if(ly_local < ty_local){
-		diry.write(NORTH);
-	}
-	else{
-		diry.write(SOUTH);
-	}
+	//Entre duas portas fica a de x: o caminho XY em west-first e north-last, e o caminho fixo mais
+	//proximo dele que negative-first e odd-even permitem
+	if(ordered && allowed[x_dir] == 1 && allowed[y_dir] == 1)
+		allowed[y_dir] = 0;
+
+	return allowed;
+}
+
+void switch_control::checkpoint(Checkpoint &ckp){
+
+	ckp.io(routed);
+	ckp.io(route);
+	ckp.io(out_vc);
+	ckp.io(request);
+	ckp.io(grant);
+	ckp.io(prio);
+	ckp.io(sender_ant);
+	ckp.io(number_pck);
 }
@@ -21,40 +21,41 @@ SC_MODULE(switch_control){
 	
 	sc_in<bool> 		clock;
 	sc_in<bool> 		reset;
-	sc_in<bool> 		h[NPORT];
-	sc_out<bool>	 	ack_h[NPORT];
-	sc_in<regflit> 		data[NPORT];
-	sc_in<bool>			sender[NPORT];
-	sc_out<bool>		free[NPORT];
-	sc_out<reg_mux> 	mux_in;
-	sc_out<reg_mux> 	mux_out;
+	// Indexed by channel, port*VC_MAX + virtual channel
+	sc_in<bool> 		h[NCHANNEL];
+	sc_out<bool>	 	ack_h[NCHANNEL];
+	sc_in<regflit> 		data[NCHANNEL];
+	sc_in<regflit> 		service[NCHANNEL];
+	sc_in<bool>			sender[NCHANNEL];
+	sc_out<bool>		free[NCHANNEL];		// Output channels
+	sc_out<regchannel> 	mux_in[NCHANNEL];	// Output channel of each input channel
+	sc_out<regchannel> 	mux_out[NCHANNEL];	// Input channel of each output channel
+	sc_in<regcredit>	credit[NPORT];		// Credit of the neighbour routers, by output port
 
-	//sinais do arbitro
-	sc_signal<bool>				ask;
-	sc_signal<sc_uint<4> >		sel, prox;
+	//sinais da computacao de rota, registrada por canal de entrada
+	sc_signal<bool>				routed[NCHANNEL];
+	sc_signal<regNport>			route[NCHANNEL];	// Output ports the routing algorithm allows for the header
+	sc_signal<regvc>			out_vc[NCHANNEL];	// Output virtual channel of the packet
 
-	//sinais do controle
-	sc_signal<regquartoflit>		dirx,diry;
-	sc_signal<regquartoflit>	lx,ly,tx,ty;
-	sc_signal<reg3>  			source[NPORT];
-	sc_signal<bool>				sender_ant[NPORT];
-
-	enum state {S0,S1,S2,S3,S4,S5,S6,S7};
-	sc_signal<state>			EA,PE;
+	//sinais do alocador
+	sc_signal<regchannel>		request[NCHANNEL];	// Output channel requested by each input channel
+	sc_signal<bool>				grant[NCHANNEL];
+	sc_signal<regchannel>		prio[NCHANNEL];		// Round robin pointer of each output channel
 
+	sc_signal<bool>				sender_ant[NCHANNEL];
 
 	int number_pck;
 	
-	void controle_comb();
+	void allocator_comb();
 	void controle_sequ();
-	void arbitro_comb();
-	void arbitro_sequ();
-	void state_sequ();
+	regNport routes(int lx, int ly, int tx, int ty, int in, bool ordered);
+	bool idle();
+	void checkpoint(Checkpoint &ckp);
 	
 	//SC_CTOR(switch_control){
 	SC_HAS_PROCESS(switch_control);
-	switch_control(sc_module_name name_, regaddress address_ = 0x0000) :
-    sc_module(name_), address(address_)
+	switch_control(sc_module_name name_, regaddress address_ = 0x0000, const NocConfig &noc_ = NocConfig()) :
+    sc_module(name_), address(address_), noc(noc_)
     {
 		//data = new sc_in<regflit >[NPORT];
 		
@@ -62,47 +63,21 @@ SC_MODULE(switch_control){
 		sensitive << reset.neg();
 		sensitive << clock.pos();
 		
-		SC_METHOD(controle_comb);
-		sensitive << reset;
-		sensitive << ask;
-		sensitive << EA;
-		sensitive << h[EAST];
-		sensitive << h[WEST];
-		sensitive << h[NORTH];
-		sensitive << h[SOUTH];
-		sensitive << h[LOCAL];
-		sensitive << lx;
-		sensitive << ly;
-		sensitive << tx;
-		sensitive << ty;
-		sensitive << free[EAST];
-		sensitive << free[WEST];
-		sensitive << free[NORTH];
-		sensitive << free[SOUTH];
-		sensitive << free[LOCAL];
-		sensitive << dirx;
-		sensitive << diry;
-				
-		SC_METHOD(arbitro_comb);
-		sensitive << h[EAST];
-		sensitive << h[WEST];
-		sensitive << h[NORTH];
-		sensitive << h[SOUTH];
-		sensitive << h[LOCAL];
-		sensitive << sel;
-		sensitive << data[EAST];
-		sensitive << data[WEST];
-		sensitive << data[NORTH];
-		sensitive << data[SOUTH];
-		sensitive << data[LOCAL];
-		
-		SC_METHOD(state_sequ);
-		sensitive << reset.neg();
-		sensitive << clock.neg();
+		SC_METHOD(allocator_comb);
+		for (int c = 0; c < NCHANNEL; c++) {
+			sensitive << routed[c];
+			sensitive << route[c];
+			sensitive << out_vc[c];
+			sensitive << free[c];
+			sensitive << prio[c];
+		}
+		for (int p = 0; p < NPORT; p++)
+			sensitive << credit[p];
 		
 	}
 	private:
 		regaddress address;
+		NocConfig noc;
 	
 };
 
@@ -0,0 +1,150 @@
+/*
+ * platform.h
+ *
+ *  Reading of include/platform.json, the flat JSON object written by
+ *  hw_builder.py with the mesh and NoC parameters of the testcase. Shared by
+ *  the test bench and the NoC bench, so both elaborate the same routers.
+ */
+
+#ifndef PLATFORM_H_
+#define PLATFORM_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "standards.h"
+
+#define PLATFORM_FILE	"include/platform.json"
+
+// Reads the platform file from the directory of the testcase
+inline bool read_platform(std::string &json){
+
+	std::ifstream platform_file (PLATFORM_FILE);
+
+	if (!platform_file.is_open()) {
+		std::cout << "Unable to open file " PLATFORM_FILE << std::endl;
+		return false;
+	}
+
+	std::stringstream content;
+	content << platform_file.rdbuf();
+	json = content.str();
+
+	return true;
+}
+
+// Reads an unsigned field of the platform file
+inline bool platform_field(const std::string &json, const char *key, unsigned int &value){
+
+	size_t pos = json.find(std::string("\"") + key + "\"");
+	if (pos == std::string::npos)
+		return false;
+
+	pos = json.find(':', pos);
+	return pos != std::string::npos && sscanf(json.c_str() + pos + 1, "%u", &value) == 1;
+}
+
+// Reads a flat array of unsigned values of the platform file
+inline bool platform_array(const std::string &json, const char *key, std::vector<unsigned int> &values){
+
+	size_t pos = json.find(std::string("\"") + key + "\"");
+	if (pos == std::string::npos)
+		return false;
+
+	pos = json.find('[', pos);
+	size_t end = json.find(']', pos);
+	if (pos == std::string::npos || end == std::string::npos)
+		return false;
+
+	std::stringstream list(json.substr(pos + 1, end - pos - 1));
+	std::string value;
+	while (getline(list, value, ','))
+		values.push_back(strtoul(value.c_str(), NULL, 0));
+
+	return true;
+}
+
+// Mesh dimensions of the platform file. Prints the error and returns false if they are invalid
+inline bool load_mesh(const std::string &json, unsigned int &x, unsigned int &y){
+
+	if (!platform_field(json, "n_pe_x", x) || !platform_field(json, "n_pe_y", y) || x == 0 || y == 0) {
+		std::cout << "ERROR: Invalid platform file " PLATFORM_FILE "\nPlease, rebuild the testcase" << std::endl;
+		return false;
+	}
+
+	// Router addresses are {x, y} with QUARTOFLIT bits each
+	if (x > (1 << QUARTOFLIT) || y > (1 << QUARTOFLIT)) {
+		std::cout << "ERROR: Mesh " << x << "x" << y << " exceeds the router address, up to " << (1 << QUARTOFLIT) << "x" << (1 << QUARTOFLIT) << " PEs" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+// Router parameters of the platform file. Prints the error and returns false if they are invalid
+inline bool load_noc_config(const std::string &json, NocConfig &noc){
+
+	unsigned int buffer_size, vcs, routing;
+	std::vector<unsigned int> vc_map, ordered_services;
+
+	// Platforms built before the field keep the default depth
+	if (!platform_field(json, "noc_buffer_size", buffer_size))
+		buffer_size = BUFFER_TAM;
+
+	if (buffer_size < BUFFER_TAM_MIN || buffer_size > BUFFER_TAM_MAX || (buffer_size & (buffer_size - 1)) != 0) {
+		std::cout << "ERROR: noc_buffer_size " << buffer_size << " must be a power of two from " << BUFFER_TAM_MIN << " to " << BUFFER_TAM_MAX << std::endl;
+		return false;
+	}
+
+	// Virtual channels of the mesh links and the pairs of service and VC of the packets
+	if (!platform_field(json, "noc_vcs", vcs))
+		vcs = 1;
+
+	if (vcs < 1 || vcs > VC_MAX) {
+		std::cout << "ERROR: noc_vcs " << vcs << " must be from 1 to " << VC_MAX << std::endl;
+		return false;
+	}
+
+	if (platform_array(json, "noc_vc_map", vc_map) && vc_map.size() % 2 != 0) {
+		std::cout << "ERROR: noc_vc_map must pair each service with a VC" << std::endl;
+		return false;
+	}
+
+	for (size_t i = 0; i < vc_map.size(); i += 2) {
+		if (vc_map[i+1] >= vcs) {
+			std::cout << "ERROR: noc_vc_map sends service 0x" << std::hex << vc_map[i] << std::dec << " to VC " << vc_map[i+1] << " of " << vcs << std::endl;
+			return false;
+		}
+		noc.service_vc[vc_map[i]] = vc_map[i+1];
+	}
+
+	if (!platform_field(json, "noc_routing", routing))
+		routing = ROUTING_XY;
+
+	if (routing >= ROUTING_COUNT) {
+		std::cout << "ERROR: Unknown noc_routing " << routing << std::endl;
+		return false;
+	}
+
+	// Services kept on a single path by the adaptive routing
+	platform_array(json, "noc_ordered_services", ordered_services);
+	noc.ordered_services.insert(ordered_services.begin(), ordered_services.end());
+
+	// The buffers that wait for the service flit drop the credit two flits before the end
+	if ((vcs > 1 || routing != ROUTING_XY) && buffer_size < BUFFER_TAM_CLASSIFY) {
+		std::cout << "ERROR: noc_buffer_size " << buffer_size << " must be at least " << BUFFER_TAM_CLASSIFY << " with virtual channels or adaptive routing" << std::endl;
+		return false;
+	}
+
+	noc.buffer_depth = buffer_size;
+	noc.vcs = vcs;
+	noc.routing = routing;
+
+	return true;
+}
+
+#endif /* PLATFORM_H_ */
@@ -10,7 +10,11 @@
 
 #include <systemc.h>
 #include <math.h>
+#include <map>
+#include <set>
 #include "../../include/hemps_pkg.h"
+#include "checkpoint.h"
+#include "image.h"
 
 #define EAST 	0
 #define WEST 	1
@@ -58,8 +62,13 @@
 //Kernel pending service FIFO
 #define PENDING_SERVICE_INTR	0x20000400
 
+//Ends the quantum override of the simulation
+#define SIM_MARKER				0x20000500
+
 #define SLACK_MONITOR_WINDOW 	50000
 
+#define CLOCK_PERIOD_NS			10
+
 //DMNI config code
 #define CODE_CS_NET 		1
 #define CODE_MEM_ADDR		2
@@ -71,7 +80,14 @@
 #define MEMORY_WORD_SIZE	4
 
 #define NPORT 				5
-#define BUFFER_TAM 			8 // must be power of two
+#define BUFFER_TAM 			8 // Default depth of the router buffers, set by noc_buffer_size in include/platform.json
+#define BUFFER_TAM_MIN		4 // The depth is a power of two in this range
+#define BUFFER_TAM_MAX		64
+#define BUFFER_TAM_CLASSIFY	8 // Least depth of the buffers that hold the header until the service flit, see fila::header_ready
+#define BUFFER_PTR_BITS		6 // Bits of the buffer pointers, log2(BUFFER_TAM_MAX)
+#define VC_MAX				4 // Virtual channels of the mesh ports, set by noc_vcs in include/platform.json
+#define VC_BITS				2 // log2(VC_MAX)
+#define NCHANNEL			(NPORT*VC_MAX) // Channels of a router, port*VC_MAX + virtual channel
 
 typedef sc_uint<TAM_FLIT > regflit;
 typedef sc_uint<16> regaddress;
@@ -89,5 +105,33 @@ typedef sc_uint<TAM_FLIT> 		regflit;
 typedef sc_uint<(TAM_FLIT/2)> 	regmetadeflit;
 typedef sc_uint<(TAM_FLIT/4)> 	regquartoflit;
 typedef sc_uint<(3*NPORT)> 		reg_mux;
+typedef sc_uint<VC_BITS> 		regvc;
+typedef sc_uint<VC_MAX> 		regcredit;	// A credit bit per virtual channel
+typedef sc_uint<5> 				regchannel;
+
+// Routing algorithms of the router, in the order of noc_routing in hw_builder.py
+enum Routing {ROUTING_XY, ROUTING_WEST_FIRST, ROUTING_NORTH_LAST, ROUTING_NEGATIVE_FIRST, ROUTING_ODD_EVEN, ROUTING_COUNT};
+
+// Router parameters, read from include/platform.json
+struct NocConfig {
+	unsigned int buffer_depth;		// Flits of each input buffer
+	unsigned int vcs;				// Virtual channels of the mesh ports, the LOCAL port has one
+	unsigned int routing;			// Routing algorithm
+	std::map<unsigned int, unsigned int> service_vc;	// Virtual channel of the packets of each service
+	std::set<unsigned int> ordered_services;			// Services the kernel expects in order, routed on a single path
+
+	NocConfig() : buffer_depth(BUFFER_TAM), vcs(1), routing(ROUTING_XY) {}
+
+	// Services out of the map use VC 0
+	unsigned int vc(unsigned int service) const {
+		std::map<unsigned int, unsigned int>::const_iterator it = service_vc.find(service);
+		return (it != service_vc.end() && it->second < vcs) ? it->second : 0;
+	}
+
+	bool ordered(unsigned int service) const { return ordered_services.count(service) != 0; }
+
+	// The buffers read the service of the packets to pick the VC at the LOCAL port, or the path in adaptive routing
+	bool classify(unsigned int port) const { return (port == LOCAL && vcs > 1) || routing != ROUTING_XY; }
+};
 
 #endif
@@ -18,51 +18,85 @@
 SC_MODULE_EXPORT(test_bench);
 #endif
 
-void test_bench::load_repository(){
-	string line;
-	int i = 0;
-	ifstream repo_file ("repository.txt");
-
-	if (repo_file.is_open()) {
-		while ( getline (repo_file,line) ) {
+bool test_bench::load_platform(){
 
-			if (i == REPO_SIZE){
-				cout << "ERROR: Repository file repository.txt is greater than REPOSIZE = " << REPO_SIZE << endl;
-				sc_stop();
-			}
+	unsigned int x, y, repo_bytes, apps;
+	string json;
 
-			//Converts a hex string to unsigned integer
-			sscanf( line.substr(0, 8).c_str(), "%lx", &repository[i] );
-			i++;
+	if (!read_platform(json) || !load_mesh(json, x, y))
+		return false;
 
-		}
-		repo_file.close();
-	} else {
-		cout << "Unable to open file repository.txt" << endl;
+	if (!platform_field(json, "repository_size_bytes", repo_bytes) || !platform_field(json, "app_number", apps)) {
+		cout << "ERROR: Invalid platform file include/platform.json\nPlease, rebuild the testcase" << endl;
+		return false;
 	}
+
+	if (!load_noc_config(json, noc))
+		return false;
+
+	n_pe_x = x;
+	n_pe_y = y;
+	n_pe = x * y;
+	repo_size = repo_bytes / 4;
+	appstart_size = apps * 2 + 1;
+
+	return true;
 }
 
-void test_bench::load_appstart(){
-	string line;
-	int i = 0;
-	ifstream appstart_file ("appstart.txt");
+// Resident host memory of the simulator, from /proc/self/status. 0 if unknown
+unsigned long test_bench::host_memory_KB(){
 
-	if (appstart_file.is_open()) {
-		while ( getline (appstart_file,line) ) {
+	char line[128];
+	unsigned long rss = 0;
+	FILE *status = fopen("/proc/self/status", "r");
 
-			if (i == APPSTART_SIZE){
-				cout << "ERROR: App Start file appstart.txt is greater than APPSTART_SIZE = " << APPSTART_SIZE << "\nPlease, recompile apps and hw" <<endl;
-				sc_stop();
-			}
+	if (status == NULL)
+		return 0;
 
-			//Converts a hex string to unsigned integer
-			sscanf( line.substr(0, 8).c_str(), "%lx", &appstart[i] );
-			i++;
+	while (fgets(line, sizeof(line), status) != NULL)
+		if (sscanf(line, "VmRSS: %lu kB", &rss) == 1)
+			break;
 
-		}
-		appstart_file.close();
-	} else {
+	fclose(status);
+	return rss;
+}
+
+// Host memory and RAM pages copied on write, to follow the simulator footprint on large meshes
+void test_bench::memory_report(){
+
+	unsigned long pages = 0;
+
+	for (int i = 0; i < n_pe; i++)
+		pages += MPSoC->PE[i]->mem->private_pages();
+
+	cout << "Host memory " << host_memory_KB() << " KB, " << pages << " of " << (unsigned long)n_pe * RAM_PAGES
+		 << " RAM pages copied on write (" << RAM_PAGE_WORDS * 4 / 1024 << " KB each)" << endl;
+}
+
+void test_bench::load_repository(){
+
+	// The binary image is mapped, the text one is only parsed when it is missing
+	if (!repository.map("repository.img") && !repository.parse("repository.txt")) {
+		cout << "Unable to open file repository.txt" << endl;
+		return;
+	}
+
+	if (repository.size > repo_size){
+		cout << "ERROR: Repository file repository.txt is greater than REPOSIZE = " << repo_size << endl;
+		sc_stop();
+	}
+}
+
+void test_bench::load_appstart(){
+
+	if (!appstart.map("appstart.img") && !appstart.parse("appstart.txt")) {
 		cout << "Unable to open file appstart.txt" << endl;
+		return;
+	}
+
+	if (appstart.size > appstart_size){
+		cout << "ERROR: App Start file appstart.txt is greater than APPSTART_SIZE = " << appstart_size << "\nPlease, recompile apps and hw" <<endl;
+		sc_stop();
 	}
 }
 
@@ -72,7 +106,7 @@ void test_bench::read_repository(){
 
 	index = index / 4;
 
-	if (index < REPO_SIZE){
+	if (index < repo_size){
 		data_read[0].write(repository[index]);
 	}
 }
@@ -120,16 +154,228 @@ void test_bench::new_app(){
 void test_bench::ClockGenerator(){
 	while(1){
 		clock.write(0);
-		wait (5, SC_NS);					//Allow signals to set
+		wait (CLOCK_PERIOD_NS/2, SC_NS);	//Allow signals to set
 		clock.write(1);
-		wait (5, SC_NS);					//Allow signals to set
+		wait (CLOCK_PERIOD_NS/2, SC_NS);	//Allow signals to set
 	}
 }
 	
 void test_bench::resetGenerator(){
+	if (restore)	// The platform state comes from the checkpoint
+		return;
+
 	reset.write(1);
 	wait (70, SC_NS);
 	reset.write(0);
 }
 
 	
+
+void test_bench::checkpoint(Checkpoint &ckp){
+
+	ckp.expect(CHECKPOINT_MAGIC);
+	ckp.expect(CHECKPOINT_VERSION);
+	ckp.expect(CHECKPOINT_CPU);
+	ckp.expect(n_pe_x);
+	ckp.expect(n_pe_y);
+	ckp.expect(RAM_SIZE);
+
+	ckp.io(current_time);
+	ckp.io(app_i);
+
+	ckp.io(reset);
+	ckp.io(address, n_pe);
+	ckp.io(data_read, n_pe);
+	ckp.io(ack_app, n_pe);
+	ckp.io(req_app, n_pe);
+
+	MPSoC->checkpoint(ckp);
+}
+
+bool test_bench::save_checkpoint(const char *ckp_file){
+
+	// Parks every CPU between two instructions and stops right after a falling edge,
+	// so both this run and the restored one resume at the next rising edge
+	Checkpoint::park() = true;
+	for (int i = 0; i < n_pe; i++)
+		MPSoC->PE[i]->wake_event.notify(SC_ZERO_TIME);
+
+	while (Checkpoint::parked() < n_pe || clock.read() == 1){
+		if (sc_end_of_simulation_invoked()){
+			Checkpoint::park() = false;
+			return false;
+		}
+		sc_start(CLOCK_PERIOD_NS/2.0, SC_NS);
+	}
+
+	Checkpoint ckp(ckp_file, true);
+	checkpoint(ckp);
+
+	Checkpoint::park() = false;
+	return ckp.ok();
+}
+
+bool test_bench::load_checkpoint(const char *ckp_file){
+
+	Checkpoint ckp(ckp_file, false);
+
+	// The CPUs start parked and without reset. The loaded signals are updated on the next sc_start
+	Checkpoint::park() = true;
+	restore = true;
+	sc_start(SC_ZERO_TIME);
+
+	checkpoint(ckp);
+
+	Checkpoint::park() = false;
+	return ckp.ok();
+}
+
+// Runs the CPUs with OVERRIDE_QUANTUM until the trigger: tick:<cycles> since reset, app:<n> acknowledged
+// application requests or marker, a write to SIM_MARKER. The NoC and the DMNI keep their timing
+bool test_bench::start_quantum_override(const char *trigger){
+
+	qo_tick = 0;
+	qo_apps = 0;
+	qo_marker = false;
+
+	if (strcmp(trigger, "marker") == 0)
+		qo_marker = true;
+	else if (sscanf(trigger, "tick:%u", &qo_tick) != 1 && sscanf(trigger, "app:%d", &qo_apps) != 1)
+		return false;
+
+	if (!qo_marker && qo_tick == 0 && qo_apps <= 0)
+		return false;
+
+	quantum_override = true;
+	for (int i = 0; i < n_pe; i++)
+		MPSoC->PE[i]->override_quantum(true);
+
+	return true;
+}
+
+void test_bench::quantum_override_monitor(){
+
+	if (!quantum_override)
+		return;
+
+	if ((qo_tick && current_time >= qo_tick) ||
+		(qo_apps && app_i/2 >= qo_apps && ack_app[0].read() == 1) ||
+		(qo_marker && pe::sim_marker)){
+
+		quantum_override = false;
+		for (int i = 0; i < n_pe; i++)
+			MPSoC->PE[i]->override_quantum(false);
+
+		cout << "Quantum override ended at " << sc_time_stamp() << ", tick " << current_time << endl;
+	}
+}
+
+static const char *noc_port_name[NPORT] = {"EAST", "WEST", "NORTH", "SOUTH", "LOCAL"};
+
+// Cycles the input buffers of the port held the given number of flits, summed over its VCs. The cycles the
+// router clock was skipped while its PE was idle have an empty buffer
+static unsigned long buffer_cycles(router_cc *router, int port, int flits, unsigned long cycles){
+
+	std::vector<unsigned long> &occupancy = router->counters[port].occupancy;
+	unsigned long count = flits < (int)occupancy.size() ? occupancy[flits] : 0;
+
+	if (flits == 0 && cycles > router->active_cycles)
+		count += cycles - router->active_cycles;
+
+	return count;
+}
+
+volatile sig_atomic_t test_bench::stop_requested = 0;
+
+// A second signal, while the simulation is stopping, kills the simulator
+void test_bench::request_stop(int sig){
+
+	stop_requested = 1;
+	signal(sig, SIG_DFL);
+}
+
+void test_bench::stop_monitor(){
+
+	if (stop_requested){
+		cout << "Simulation stopped by signal at " << sc_time_stamp() << endl;
+		sc_stop();
+	}
+}
+
+void test_bench::noc_monitor(){
+
+	if (noc_interval && current_time && current_time % noc_interval == 0)
+		noc_rows();
+}
+
+// One line per router port of log_noc.csv, with the counters since reset:
+// cycle,router,port,flits_in,flits_out,packets,credit_blocked,arbitration_wait,utilization,occupancy_0..occupancy_N
+// Utilization is flits_out per cycle of the link
+void test_bench::noc_rows(){
+
+	if (noc_csv == NULL){
+		noc_csv = fopen("log_noc.csv", "w");
+		if (noc_csv == NULL)
+			return;
+
+		fprintf(noc_csv, "cycle,router,port,flits_in,flits_out,packets,credit_blocked,arbitration_wait,utilization");
+		for (int b = 0; b < (int)(noc.vcs * noc.buffer_depth); b++)
+			fprintf(noc_csv, ",occupancy_%d", b);
+		fprintf(noc_csv, "\n");
+	}
+
+	for (int i = 0; i < n_pe; i++){
+		router_cc *router = MPSoC->PE[i]->router;
+		unsigned int address = (unsigned int)MPSoC->PE[i]->router_address;
+
+		for (int p = 0; p < NPORT; p++){
+			PortCounters &c = router->counters[p];
+
+			fprintf(noc_csv, "%u,%ux%u,%s,%lu,%lu,%lu,%lu,%lu,%.4f", current_time, address >> 8, address & 0xFF, noc_port_name[p],
+				c.flits_in, c.flits_out, c.packets, c.credit_blocked, c.arbitration_wait, current_time ? (double)c.flits_out / current_time : 0);
+
+			for (int b = 0; b < (int)(noc.vcs * noc.buffer_depth); b++)
+				fprintf(noc_csv, ",%lu", buffer_cycles(router, p, b, current_time));
+			fprintf(noc_csv, "\n");
+		}
+	}
+}
+
+// Final counters in log_noc.csv and log_noc.json
+void test_bench::noc_report(){
+
+	noc_rows();
+	if (noc_csv != NULL)
+		fclose(noc_csv);
+
+	fp = fopen("log_noc.json", "w");
+	if (fp == NULL)
+		return;
+
+	fprintf(fp, "{\n  \"cycles\": %u,\n  \"routers\": [\n", current_time);
+
+	for (int i = 0; i < n_pe; i++){
+		router_cc *router = MPSoC->PE[i]->router;
+		unsigned int address = (unsigned int)MPSoC->PE[i]->router_address;
+
+		fprintf(fp, "    {\"x\": %u, \"y\": %u, \"active_cycles\": %lu, \"ports\": [\n", address >> 8, address & 0xFF, router->active_cycles);
+
+		for (int p = 0; p < NPORT; p++){
+			PortCounters &c = router->counters[p];
+
+			fprintf(fp, "      {\"port\": \"%s\", \"flits_in\": %lu, \"flits_out\": %lu, \"packets\": %lu, \"credit_blocked\": %lu, "
+				"\"arbitration_wait\": %lu, \"utilization\": %.4f, \"occupancy\": [", noc_port_name[p], c.flits_in, c.flits_out, c.packets,
+				c.credit_blocked, c.arbitration_wait, current_time ? (double)c.flits_out / current_time : 0);
+
+			for (int b = 0; b < (int)c.occupancy.size(); b++)
+				fprintf(fp, "%s%lu", b ? ", " : "", buffer_cycles(router, p, b, current_time));
+
+			fprintf(fp, "]}%s\n", p < NPORT-1 ? "," : "");
+		}
+
+		fprintf(fp, "    ]}%s\n", i < n_pe-1 ? "," : "");
+	}
+
+	fprintf(fp, "  ]\n}\n");
+	fclose(fp);
+}
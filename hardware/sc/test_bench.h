@@ -15,14 +15,18 @@
 #include <systemc.h>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
+#include <string.h>
+#include <time.h>
+#include <signal.h>
+#include <vector>
 
 using namespace std;
 
 #include "hemps.h"
-
-#define REPO_SIZE	TOTAL_REPO_SIZE_BYTES/4
-#define APPSTART_SIZE	(APP_NUMBER*2)+1
+#include "latency.h"
+#include "platform.h"
 
 SC_MODULE(test_bench) {
 	
@@ -37,19 +41,56 @@ SC_MODULE(test_bench) {
 	void new_app();
 	void load_repository();
 	void load_appstart();
+
+	// Platform configuration, read from include/platform.json at elaboration
+	int n_pe_x, n_pe_y, n_pe;
+	unsigned int repo_size, appstart_size;	// In words
+	NocConfig noc;							// Router buffers and virtual channels
+	bool load_platform();
+
+	static unsigned long host_memory_KB();
+	void memory_report();
+
+	// Checkpoint and restore
+	bool restore;
+	void checkpoint(Checkpoint &ckp);
+	bool save_checkpoint(const char *ckp_file);
+	bool load_checkpoint(const char *ckp_file);
+
+	// Quantum override: the CPUs run with OVERRIDE_QUANTUM until a trigger. This is not a functional
+	// mode, the NoC and the DMNI stay cycle accurate
+	bool quantum_override;
+	unsigned int qo_tick;
+	int qo_apps;
+	bool qo_marker;
+	bool start_quantum_override(const char *trigger);
+	void quantum_override_monitor();
+
+	// NoC counters, written to log_noc.csv every noc_interval cycles if set and to log_noc.csv
+	// and log_noc.json at the end of the simulation
+	unsigned int noc_interval;
+	FILE *noc_csv;
+	void noc_monitor();
+	void noc_rows();
+	void noc_report();
+
+	// SIGINT and SIGTERM end the simulation on the next clock, so the logs and reports are written
+	static volatile sig_atomic_t stop_requested;
+	static void request_stop(int sig);
+	void stop_monitor();
 	
 	hemps *MPSoC;
 
 	//Tasks repository interface
-	sc_signal<sc_uint<30> >		address[N_PE];
-	sc_signal<sc_uint<32> > 	data_read[N_PE];
+	sc_signal<sc_uint<30> >		*address;
+	sc_signal<sc_uint<32> > 	*data_read;
 	
 	//Dynamic Insertion of Applications
-	sc_signal<bool > 			ack_app[N_PE];
-    sc_signal<sc_uint<32> >     req_app[N_PE];
+	sc_signal<bool > 			*ack_app;
+    sc_signal<sc_uint<32> >     *req_app;
     
-    unsigned long repository[REPO_SIZE];
-    unsigned long appstart[APPSTART_SIZE];
+    MemoryImage repository;
+    MemoryImage appstart;
 
     unsigned int current_time;
     int app_i;
@@ -63,14 +104,27 @@ SC_MODULE(test_bench) {
     sc_module(name_), filename(filename_)
     {
 		
+		restore = false;
+		quantum_override = false;
+		noc_interval = 0;
+		noc_csv = NULL;
+
+		if (!load_platform())
+			exit(EXIT_FAILURE);
+
 		load_repository();
 		load_appstart();
 
-		MPSoC = new hemps("HeMPS");
+		address = new sc_signal<sc_uint<30> >[n_pe];
+		data_read = new sc_signal<sc_uint<32> >[n_pe];
+		ack_app = new sc_signal<bool >[n_pe];
+		req_app = new sc_signal<sc_uint<32> >[n_pe];
+
+		MPSoC = new hemps("HeMPS", n_pe_x, n_pe_y, noc);
 		MPSoC->clock(clock);
 		MPSoC->reset(reset);
 
-		for(int i =0; i<N_PE; i++){
+		for(int i =0; i<n_pe; i++){
 			MPSoC->mem_addr[i](address[i]);
 			MPSoC->data_read[i](data_read[i]);
 			MPSoC->ack_app[i](ack_app[i]);
@@ -85,6 +139,18 @@ SC_MODULE(test_bench) {
 		sensitive << clock;
 		sensitive << reset;
 		
+		SC_METHOD(quantum_override_monitor);
+		sensitive << clock.pos();
+		dont_initialize();
+
+		SC_METHOD(noc_monitor);
+		sensitive << clock.pos();
+		dont_initialize();
+
+		SC_METHOD(stop_monitor);
+		sensitive << clock.pos();
+		dont_initialize();
+
 		SC_THREAD(ClockGenerator);
 
 		SC_THREAD(resetGenerator);
@@ -98,7 +164,7 @@ SC_MODULE(test_bench) {
 		fp = fopen (aux, "w+");
 		fclose (fp);	
 
-		for(int j=0;j<N_PE;j++){
+		for(int j=0;j<n_pe;j++){
 			//Store in aux the c's string way, in address how many char were builded
 			sprintf(aux, "log_energy.txt");
 			// Open a file called aux deferred on append mode
@@ -136,7 +202,7 @@ SC_MODULE(test_bench) {
 					
 		}
 		
-		for(int j=0;j<N_PE;j++)
+		for(int j=0;j<n_pe;j++)
 		{
 			
 			//Store in aux the c's string way, in address how many char were builded
@@ -144,6 +210,10 @@ SC_MODULE(test_bench) {
 			// Open a file called aux deferred on append mode
 			fp = fopen (aux, "a");
 
+		#ifdef RISCV_SIM
+			MPSoC-> PE[j] ->cpu->update_stats();
+		#endif
+
 			sprintf(aux, "PROC %d Arithmetic_tasks %lu ",j, MPSoC-> PE[j] ->cpu->arith_inst_tasks);
 			fprintf(fp,"%s",aux);
 			sprintf(aux, "Load-Store_tasks %lu ", MPSoC-> PE[j] ->cpu->load_inst_tasks);
@@ -195,6 +265,10 @@ SC_MODULE(test_bench) {
 			fclose (fp);
 
 		}
+
+		noc_report();
+
+		Latency::report();
 					
 	}
 	private:
@@ -208,8 +282,12 @@ int sc_main(int argc, char *argv[]){
 	int time_to_run=0;
 	int i;
 	char *filename = "output_master.txt";
+	char *save_file = NULL;
+	char *restore_file = NULL;
+	char *qo_trigger = NULL;
+	unsigned int noc_interval = 0;
 	if(argc<3){
-		cout << "Sintax: " << argv[0] << " -c <milisecons to execute> [-o <output filename>]" << endl;
+		cout << "Sintax: " << argv[0] << " -c <milisecons to execute> [-o <output filename>] [-r <checkpoint to restore>] [-s <checkpoint to save>] [-q tick:<cycles>|app:<n>|marker] [-n <NoC counters interval in cycles>]" << endl;
 		exit(EXIT_FAILURE);
 	}
 	
@@ -223,8 +301,20 @@ int sc_main(int argc, char *argv[]){
 					filename = argv[++i];
 					cout << filename << endl;
 				break;
+				case 'r':
+					restore_file = argv[++i];
+				break;
+				case 's':
+					save_file = argv[++i];
+				break;
+				case 'q':
+					qo_trigger = argv[++i];
+				break;
+				case 'n':
+					noc_interval = atoi(argv[++i]);
+				break;
 				default:
-					cout << "Sintax: " << argv[0] << "-c <milisecons to execute> [-o <output name file>]" << endl;
+					cout << "Sintax: " << argv[0] << "-c <milisecons to execute> [-o <output name file>] [-r <checkpoint to restore>] [-s <checkpoint to save>] [-q tick:<cycles>|app:<n>|marker] [-n <NoC counters interval in cycles>]" << endl;
 					exit(EXIT_FAILURE);
 				break;
 			}
@@ -232,8 +322,52 @@ int sc_main(int argc, char *argv[]){
 	}
 	
 	
+	unsigned long host_memory = test_bench::host_memory_KB();
+	clock_t elaboration = clock();
+
 	test_bench tb("testbench",filename);
+	tb.noc_interval = noc_interval;
+
+	cout << "Elaborated " << tb.n_pe_x << "x" << tb.n_pe_y << " PEs in " << (clock() - elaboration) * 1000 / CLOCKS_PER_SEC << " ms, "
+		 << (test_bench::host_memory_KB() - host_memory) / tb.n_pe << " KB of host memory per PE" << endl;
+
+	if (restore_file != NULL){
+		if (!tb.load_checkpoint(restore_file)){
+			cout << "ERROR: Unable to restore checkpoint " << restore_file << endl;
+			exit(EXIT_FAILURE);
+		}
+		cout << "Restored checkpoint " << restore_file << endl;
+	}
+
+#if !DMI_ENABLE
+	// Without DMI every load and store still syncs with the clock, so the override would do nothing
+	if (qo_trigger != NULL){
+		cout << "ERROR: -q needs the DMI, set dmi: yes in the testcase and rebuild it" << endl;
+		exit(EXIT_FAILURE);
+	}
+#endif
+
+	if (qo_trigger != NULL && !tb.start_quantum_override(qo_trigger)){
+		cout << "ERROR: Unknown quantum override trigger " << qo_trigger << ". Use tick:<cycles>, app:<n> or marker" << endl;
+		exit(EXIT_FAILURE);
+	}
+
+	signal(SIGINT, test_bench::request_stop);
+	signal(SIGTERM, test_bench::request_stop);
+
 	sc_start(time_to_run,SC_MS);
+
+	Logger::flush();
+
+	tb.memory_report();
+
+	if (save_file != NULL && !sc_end_of_simulation_invoked()){
+		if (!tb.save_checkpoint(save_file)){
+			cout << "ERROR: Unable to save checkpoint " << save_file << endl;
+			exit(EXIT_FAILURE);
+		}
+		cout << "Saved checkpoint " << save_file << " at " << sc_time_stamp() << endl;
+	}
   	return 0;
 }
 #endif
@@ -66,6 +66,9 @@
 
 #define SLACK_TIME_MONITOR		0x20000370
 
+//Ends the quantum override of the simulation
+#define SIM_MARKER			0x20000500
+
 //Kernel pending service FIFO
 #define PENDING_SERVICE_INTR	0x20000400
 